@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include "assembler.h"
+
+// Command-line front end for assembler.h: assembles and links the given
+// sources into one flat image.
+//
+//   assembler [-o image.bin] [-b base] [-m image.map] [-l] file.s...
+
+void printUsage() {
+    std::cerr << "Usage: assembler [-o image.bin] [-b base] [-m image.map] [-l] file.s..." << std::endl;
+    std::cerr << "  -o  output image (default program.bin)" << std::endl;
+    std::cerr << "  -b  load address, 0-0xffff (default 0)" << std::endl;
+    std::cerr << "  -m  write a symbol map" << std::endl;
+    std::cerr << "  -l  print a listing" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string output = "program.bin";
+    std::string mapPath;
+    uint32_t base = 0;
+    bool listing = false;
+    isa::Assembler assembler;
+    int sources = 0;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if((arg == "-o" || arg == "-b" || arg == "-m") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if(arg == "-o") {
+                output = value;
+            } else if(arg == "-m") {
+                mapPath = value;
+            } else {
+                char* end = nullptr;
+                unsigned long parsed = std::strtoul(value.c_str(), &end, 0);
+                if(value.empty() || value[0] == '-' || *end != '\0' || parsed > 0xFFFF) {
+                    std::cerr << "Invalid load address: " << value << std::endl;
+                    printUsage();
+                    return 2;
+                }
+                base = static_cast<uint32_t>(parsed);
+            }
+        } else if(arg == "-l") {
+            listing = true;
+        } else if(!arg.empty() && arg[0] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            assembler.addFile(arg);
+            sources++;
+        }
+    }
+    if(sources == 0) {
+        printUsage();
+        return 2;
+    }
+
+    isa::Image image;
+    if(!assembler.link(base, image)) {
+        for(const auto& message : assembler.errors()) std::cerr << message << std::endl;
+        return 1;
+    }
+
+    std::string error;
+    if(!isa::writeImage(output, image, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if(!mapPath.empty() && !isa::writeSymbolMap(mapPath, image, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if(listing) {
+        for(const auto& line : image.listing) std::cout << line << std::endl;
+    }
+
+    char summary[96];
+    std::snprintf(summary, sizeof(summary), "%s: %u bytes at 0x%04x, entry 0x%04x", output.c_str(),
+                  static_cast<unsigned>(image.bytes.size()), image.base, image.entry);
+    std::cout << summary << std::endl;
+    return 0;
+}
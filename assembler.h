@@ -0,0 +1,799 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+#include <cstdio>
+#include "isa.h"
+
+// Two-pass assembler and linker for the 16-bit ISA. Sources are added one
+// file at a time; labels and .equ constants are local to their file unless
+// a label is named in .global, and link() lays every file out in one
+// address space, in the order they were added, resolving references
+// between them.
+//
+//   pass 1  assigns addresses, repeating until every branch reaches its
+//           target: a conditional branch out of the -8..+7 range becomes
+//           an inverted branch over a JAL, which only ever grows the code,
+//           so the loop terminates
+//   pass 2  encodes, checks operand ranges and builds the listing
+//
+// Syntax: one statement per line, "label:" prefixes, ";" or "//" comments,
+// registers x0-x15 (also zero, sp, lr) and v0-v7 for the SIMD extension
+// (VLD v, (xN)+; VCMPEQ/VXOR/VMAC v, w; VPOPC xN, v; VREDSUM/VLENB xN),
+// operands that are sums and differences of numbers and symbols.
+//
+// Directives: .org .align .word .half .byte .space .global .equ
+//
+// Pseudo-instructions:
+//   LI rd, expr      constants in -8..7 are one ADDI, up to two signed
+//                    base-16 digits are ADDI, MULI 4, MULI 4, ADDI; anything
+//                    else (including symbols) is an inline literal: JAL rd
+//                    jumps over the word leaving its address in rd, then
+//                    LW rd, 0(rd). Always 10 bytes, NOP-padded to align.
+//   LA rd, sym       same as LI
+//   MV rd, rs        ADD rd, rs, x0
+//   J t / CALL t     JAL x0, t / JAL lr, t
+//   RET              JR lr
+//   HALT             SLEEPM 15
+//   BGT a, b, t      BLT b, a, t
+//   BEQZ r, t        BEQ r, x0, t   (BNEZ likewise)
+//   DOT4.B / DOT2.H  MAC rd, rs1, rs2; only a dot product after MACMODE 1 / 2
+//
+// LOOP xN, end runs the instructions from the next one up to the label end
+// x[N] times; the body must come out at 1-8 instructions after relaxation.
+namespace isa {
+
+struct Image {
+    uint32_t base;
+    uint32_t entry;
+    std::vector<uint8_t> bytes;
+    std::map<std::string, uint32_t> symbols;   // file-local labels appear as "file:label"
+    std::vector<std::string> listing;
+
+    Image() : base(0), entry(0) {}
+
+    uint32_t end() const { return base + static_cast<uint32_t>(bytes.size()); }
+};
+
+// Flat binary: a 16-byte header ("LT16", then base, entry and byte count
+// as little-endian uint32) followed by the image bytes
+inline bool writeImage(const std::string& path, const Image& image, std::string& error) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if(!out) {
+        error = "cannot create " + path;
+        return false;
+    }
+    uint32_t header[3] = {image.base, image.entry, static_cast<uint32_t>(image.bytes.size())};
+    out.write("LT16", 4);
+    for(uint32_t field : header) {
+        uint8_t le[4] = {static_cast<uint8_t>(field), static_cast<uint8_t>(field >> 8),
+                         static_cast<uint8_t>(field >> 16), static_cast<uint8_t>(field >> 24)};
+        out.write(reinterpret_cast<const char*>(le), 4);
+    }
+    out.write(reinterpret_cast<const char*>(image.bytes.data()), image.bytes.size());
+    if(!out) {
+        error = "write failed for " + path;
+        return false;
+    }
+    return true;
+}
+
+inline bool readImage(const std::string& path, Image& image, std::string& error) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    uint8_t header[16];
+    if(!in || !in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+       header[0] != 'L' || header[1] != 'T' || header[2] != '1' || header[3] != '6') {
+        error = path + " is not a flat ISA image";
+        return false;
+    }
+    uint32_t fields[3];
+    for(int i = 0; i < 3; i++) {
+        const uint8_t* le = header + 4 + 4 * i;
+        fields[i] = le[0] | (le[1] << 8) | (le[2] << 16) | (static_cast<uint32_t>(le[3]) << 24);
+    }
+    image = Image();
+    image.base = fields[0];
+    image.entry = fields[1];
+    image.bytes.resize(fields[2]);
+    if(!in.read(reinterpret_cast<char*>(image.bytes.data()), image.bytes.size())) {
+        error = path + " is truncated";
+        return false;
+    }
+    return true;
+}
+
+// Symbol map: one line per symbol, the address as four hex digits, two
+// spaces and the name
+inline bool writeSymbolMap(const std::string& path, const Image& image, std::string& error) {
+    std::ofstream out(path.c_str());
+    for(const auto& symbol : image.symbols) {
+        char address[16];
+        std::snprintf(address, sizeof(address), "%04x  ", symbol.second);
+        out << address << symbol.first << "\n";
+    }
+    if(!out) {
+        error = "write failed for " + path;
+        return false;
+    }
+    return true;
+}
+
+inline bool readSymbolMap(const std::string& path, Image& image, std::string& error) {
+    std::ifstream in(path.c_str());
+    if(!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    for(int number = 1; std::getline(in, line); number++) {
+        if(line.empty()) continue;
+        char* end = nullptr;
+        unsigned long address = std::strtoul(line.c_str(), &end, 16);
+        if(end == line.c_str() || address > 0xFFFF || end[0] != ' ' || end[1] != ' ' || end[2] == '\0') {
+            error = path + ":" + std::to_string(number) + ": expected an address and a symbol";
+            return false;
+        }
+        image.symbols[end + 2] = static_cast<uint32_t>(address);
+    }
+    return true;
+}
+
+class Assembler {
+private:
+    static const uint32_t ADDRESS_SPACE = 64 * 1024;
+
+    struct Statement {
+        std::string file;
+        int line;
+        std::string label;               // symbol key when this statement defines a label
+        std::string op;                  // upper-case mnemonic or directive, empty for a label
+        std::vector<std::string> args;
+        std::string source;              // original text, for the listing
+        uint32_t address;
+        uint32_t size;
+        bool relaxed;                    // branch rewritten to reach a far target
+    };
+
+    std::vector<Statement> statements;
+    std::map<std::string, int64_t> constants;     // "file:name" -> .equ value
+    std::map<std::string, uint32_t> labels;       // symbol key -> address in the current layout
+    std::set<std::string> definedSymbols;
+    std::vector<std::string> messages;
+
+    static std::string trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if(first == std::string::npos) return "";
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return text.substr(first, last - first + 1);
+    }
+
+    static std::string upper(std::string text) {
+        for(auto& c : text) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        return text;
+    }
+
+    static bool isIdentifier(const std::string& text) {
+        if(text.empty() || std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+        for(char c : text) {
+            if(!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.') return false;
+        }
+        return true;
+    }
+
+    static std::string scoped(const std::string& file, const std::string& name) {
+        return file + ":" + name;
+    }
+
+    static bool fitsSigned(int64_t value, int bits) {
+        return value >= -(int64_t(1) << (bits - 1)) && value < (int64_t(1) << (bits - 1));
+    }
+
+    void error(const std::string& file, int line, const std::string& message) {
+        messages.push_back(file + ":" + std::to_string(line) + ": " + message);
+    }
+
+    void error(const Statement& st, const std::string& message) {
+        error(st.file, st.line, message);
+    }
+
+    static std::vector<std::string> splitOperands(const std::string& text) {
+        std::vector<std::string> operands;
+        std::string current;
+        for(char c : text) {
+            if(c == ',') {
+                operands.push_back(trim(current));
+                current.clear();
+            } else {
+                current += c;
+            }
+        }
+        if(!trim(current).empty() || !operands.empty()) operands.push_back(trim(current));
+        return operands;
+    }
+
+    static int parseRegister(const std::string& text) {
+        std::string name = upper(trim(text));
+        if(name == "ZERO") return 0;
+        if(name == "SP") return REG_SP;
+        if(name == "LR") return REG_LR;
+        if(name.size() < 2 || name.size() > 3 || name[0] != 'X') return -1;
+        for(size_t i = 1; i < name.size(); i++) {
+            if(!std::isdigit(static_cast<unsigned char>(name[i]))) return -1;
+        }
+        int reg = std::atoi(name.c_str() + 1);
+        return reg < REG_COUNT ? reg : -1;
+    }
+
+    static int parseVectorRegister(const std::string& text) {
+        std::string name = upper(trim(text));
+        if(name.size() != 2 || name[0] != 'V' || name[1] < '0' || name[1] >= '0' + VECTOR_REGS) return -1;
+        return name[1] - '0';
+    }
+
+    bool lookup(const std::string& name, const std::string& file, bool constantsOnly, int64_t& value) const {
+        auto constant = constants.find(scoped(file, name));
+        if(constant != constants.end()) {
+            value = constant->second;
+            return true;
+        }
+        if(constantsOnly) return false;
+        auto label = labels.find(scoped(file, name));
+        if(label == labels.end()) label = labels.find(name);
+        if(label == labels.end()) return false;
+        value = label->second;
+        return true;
+    }
+
+    // Sums the +/- separated terms of text; on failure problem names the
+    // term that could not be resolved
+    bool evaluate(const std::string& text, const std::string& file, bool constantsOnly,
+                  int64_t& value, std::string& problem) const {
+        value = 0;
+        std::string expression = trim(text);
+        if(expression.empty()) {
+            problem = "missing operand";
+            return false;
+        }
+        size_t pos = 0;
+        int sign = 1;
+        if(expression[0] == '-' || expression[0] == '+') {
+            sign = expression[0] == '-' ? -1 : 1;
+            pos = 1;
+        }
+        while(pos <= expression.size()) {
+            size_t next = expression.find_first_of("+-", pos);
+            std::string term = trim(expression.substr(pos, next == std::string::npos ? std::string::npos : next - pos));
+            int64_t termValue = 0;
+            if(term.empty()) {
+                problem = "malformed expression '" + expression + "'";
+                return false;
+            }
+            if(std::isdigit(static_cast<unsigned char>(term[0]))) {
+                char* end = nullptr;
+                bool binary = term.size() > 2 && term[0] == '0' && (term[1] == 'b' || term[1] == 'B');
+                termValue = std::strtoll(binary ? term.c_str() + 2 : term.c_str(), &end,
+                                         binary ? 2 : (term.size() > 2 && (term[1] == 'x' || term[1] == 'X')) ? 16 : 10);
+                if(*end != '\0') {
+                    problem = "bad number '" + term + "'";
+                    return false;
+                }
+            } else if(!isIdentifier(term)) {
+                problem = "bad operand '" + term + "'";
+                return false;
+            } else if(!lookup(term, file, constantsOnly, termValue)) {
+                problem = constantsOnly ? "'" + term + "' is not a constant" : "undefined symbol '" + term + "'";
+                return false;
+            }
+            value += sign * termValue;
+            if(next == std::string::npos) break;
+            sign = expression[next] == '-' ? -1 : 1;
+            pos = next + 1;
+        }
+        return true;
+    }
+
+    static bool isBranch(const std::string& op) {
+        return op == "BEQ" || op == "BNE" || op == "BLT";
+    }
+
+    // Rewrites pseudo-instructions that are a single real instruction
+    static void expandAlias(std::string& op, std::vector<std::string>& args) {
+        if(op == "MV" && args.size() == 2) {
+            op = "ADD";
+            args.push_back("x0");
+        } else if(op == "J" && args.size() == 1) {
+            op = "JAL";
+            args.insert(args.begin(), "x0");
+        } else if(op == "CALL" && args.size() == 1) {
+            op = "JAL";
+            args.insert(args.begin(), "lr");
+        } else if(op == "RET" && args.empty()) {
+            op = "JR";
+            args.push_back("lr");
+        } else if(op == "HALT" && args.empty()) {
+            op = "SLEEPM";
+            args.push_back(std::to_string(SLEEP_POWER_OFF));
+        } else if(op == "BGT" && args.size() == 3) {
+            op = "BLT";
+            std::swap(args[0], args[1]);
+        } else if((op == "BEQZ" || op == "BNEZ") && args.size() == 2) {
+            op = op == "BEQZ" ? "BEQ" : "BNE";
+            args.insert(args.begin() + 1, "x0");
+        } else if(op == "LA") {
+            op = "LI";
+        }
+    }
+
+    void parseLine(const std::string& file, int line, const std::string& raw, std::set<std::string>& globals) {
+        std::string text = raw;
+        size_t comment = std::min(text.find(';'), text.find("//"));
+        if(comment != std::string::npos) text = text.substr(0, comment);
+        text = trim(text);
+
+        // Leading labels; a label sharing its line with an instruction
+        // leaves the listing text to the instruction
+        size_t firstLabel = statements.size();
+        for(size_t colon = text.find(':'); colon != std::string::npos; colon = text.find(':')) {
+            std::string name = trim(text.substr(0, colon));
+            if(!isIdentifier(name)) break;
+            Statement label = {file, line, name, "", {}, trim(raw), 0, 0, false};
+            statements.push_back(label);
+            text = trim(text.substr(colon + 1));
+        }
+        if(text.empty()) return;
+        for(size_t i = firstLabel; i < statements.size(); i++) statements[i].source.clear();
+
+        size_t split = text.find_first_of(" \t");
+        std::string op = upper(text.substr(0, split));
+        std::vector<std::string> args = split == std::string::npos ? std::vector<std::string>()
+                                                                   : splitOperands(text.substr(split));
+        if(op == ".GLOBAL") {
+            for(const auto& name : args) globals.insert(name);
+            return;
+        }
+        if(op == ".EQU") {
+            int64_t value = 0;
+            std::string problem;
+            if(args.size() != 2 || !isIdentifier(args[0])) {
+                error(file, line, ".equ needs a name and a value");
+            } else if(!evaluate(args[1], file, true, value, problem)) {
+                error(file, line, problem);
+            } else if(!constants.insert(std::make_pair(scoped(file, args[0]), value)).second) {
+                error(file, line, "'" + args[0] + "' is already defined");
+            }
+            return;
+        }
+        expandAlias(op, args);
+        Statement st = {file, line, "", op, args, trim(raw), 0, 0, false};
+        statements.push_back(st);
+    }
+
+    // Bytes taken by st at address in the current layout
+    uint32_t sizeOf(const Statement& st, uint32_t address) const {
+        int64_t value = 0;
+        std::string problem;
+        if(st.op.empty()) return 0;
+        if(st.op == ".ALIGN") {
+            if(!evaluate(st.args.empty() ? "" : st.args[0], st.file, true, value, problem) || value <= 0) return 0;
+            return static_cast<uint32_t>((value - address % value) % value);
+        }
+        if(st.op == ".WORD") return 4 * static_cast<uint32_t>(st.args.size());
+        if(st.op == ".HALF") return 2 * static_cast<uint32_t>(st.args.size());
+        if(st.op == ".BYTE") return static_cast<uint32_t>(st.args.size());
+        if(st.op == ".SPACE") {
+            if(!evaluate(st.args.empty() ? "" : st.args[0], st.file, true, value, problem) || value < 0) return 0;
+            return static_cast<uint32_t>(value);
+        }
+        if(st.op == "LI") {
+            if(st.args.size() == 2 && evaluate(st.args[1], st.file, true, value, problem)) {
+                if(fitsSigned(value, 4)) return 2;
+                int64_t low = ((value + 8) & 0xF) - 8;
+                if(fitsSigned((value - low) / 16, 4)) return low == 0 ? 6 : 8;
+            }
+            return 10;
+        }
+        if(isBranch(st.op) && st.relaxed) return st.op == "BLT" ? 6 : 4;
+        return 2;
+    }
+
+    void layout(uint32_t base) {
+        for(;;) {
+            uint32_t address = base;
+            labels.clear();
+            for(auto& st : statements) {
+                if(st.op == ".ORG") {
+                    int64_t target = 0;
+                    std::string problem;
+                    if(st.args.size() == 1 && evaluate(st.args[0], st.file, true, target, problem) && target > address) {
+                        address = static_cast<uint32_t>(target);
+                    }
+                }
+                st.address = address;
+                st.size = sizeOf(st, address);
+                address += st.size;
+                if(!st.label.empty()) labels[st.label] = st.address;
+            }
+
+            bool grown = false;
+            for(auto& st : statements) {
+                if(!isBranch(st.op) || st.relaxed || st.args.size() != 3) continue;
+                int64_t target = 0;
+                std::string problem;
+                if(!evaluate(st.args[2], st.file, false, target, problem)) continue;
+                if(!fitsSigned((target - (static_cast<int64_t>(st.address) + 2)) / 2, 4)) {
+                    st.relaxed = true;
+                    grown = true;
+                }
+            }
+            if(!grown) return;
+        }
+    }
+
+    bool registerOperand(const Statement& st, size_t index, int& reg) {
+        reg = index < st.args.size() ? parseRegister(st.args[index]) : -1;
+        if(reg < 0) error(st, "operand " + std::to_string(index + 1) + " of " + st.op + " must be a register");
+        return reg >= 0;
+    }
+
+    bool vectorOperand(const Statement& st, size_t index, int& reg) {
+        reg = index < st.args.size() ? parseVectorRegister(st.args[index]) : -1;
+        if(reg < 0) error(st, "operand " + std::to_string(index + 1) + " of " + st.op + " must be a vector register");
+        return reg >= 0;
+    }
+
+    bool valueOperand(const Statement& st, const std::string& text, int64_t& value) {
+        std::string problem;
+        if(!evaluate(text, st.file, false, value, problem)) {
+            error(st, problem);
+            return false;
+        }
+        return true;
+    }
+
+    // Offset in instructions from the instruction after from to target
+    bool offsetTo(const Statement& st, const std::string& text, uint32_t from, int bits, int& offset) {
+        int64_t target = 0;
+        if(!valueOperand(st, text, target)) return false;
+        int64_t distance = target - (static_cast<int64_t>(from) + 2);
+        if(target & 1) {
+            error(st, "jump target is not halfword aligned");
+            return false;
+        }
+        if(!fitsSigned(distance / 2, bits)) {
+            error(st, "target out of range for " + st.op);
+            return false;
+        }
+        offset = static_cast<int>(distance / 2);
+        return true;
+    }
+
+    bool expectOperands(const Statement& st, size_t count) {
+        if(st.args.size() == count) return true;
+        error(st, st.op + " takes " + std::to_string(count) + " operands");
+        return false;
+    }
+
+    // "offset(xN)" -> base register and byte offset
+    bool memoryOperand(const Statement& st, const std::string& text, int& base, int64_t& offset) {
+        size_t open = text.rfind('(');
+        size_t close = text.rfind(')');
+        if(open == std::string::npos || close == std::string::npos || close < open) {
+            error(st, "expected offset(register), got '" + text + "'");
+            return false;
+        }
+        base = parseRegister(text.substr(open + 1, close - open - 1));
+        if(base < 0) {
+            error(st, "bad base register in '" + text + "'");
+            return false;
+        }
+        std::string offsetText = trim(text.substr(0, open));
+        offset = 0;
+        return offsetText.empty() || valueOperand(st, offsetText, offset);
+    }
+
+    // Encodes one instruction statement; returns false (after reporting)
+    // when it cannot
+    bool encode(const Statement& st, std::vector<uint16_t>& code) {
+        static const std::map<std::string, int> rType = {
+            {"ADD", OP_ADD}, {"SUB", OP_SUB}, {"AND", OP_AND}, {"OR", OP_OR},
+            {"MAC", OP_MAC}, {"VCMPEQ.B", OP_VCMPEQB}
+        };
+        static const std::map<std::string, int> iType = {{"ADDI", OP_ADDI}, {"MULI", OP_MULI}, {"XORI", OP_XORI}};
+        static const std::map<std::string, int> memory = {{"LW", OP_LW}, {"SW", OP_SW}, {"LHB", OP_LHB}};
+        static const std::map<std::string, int> branches = {{"BEQ", OP_BEQ}, {"BNE", OP_BNE}, {"BLT", OP_BLT}};
+        static const std::map<std::string, int> vectorPairs = {{"VCMPEQ", OP_SUB}, {"VXOR", OP_AND}, {"VMAC", OP_MAC}};
+        int rd = 0, rs1 = 0, rs2 = 0, offset = 0;
+        int64_t value = 0;
+
+        if(rType.count(st.op)) {
+            if(!expectOperands(st, 3) || !registerOperand(st, 0, rd) || !registerOperand(st, 1, rs1) ||
+               !registerOperand(st, 2, rs2)) return false;
+            if(rd == 0 && !(st.op == "ADD" && rs2 == 0)) {
+                error(st, st.op + " into x0 encodes a SIMD instruction");
+                return false;
+            }
+            code.push_back(encodeR(rType.at(st.op), rd, rs1, rs2));
+        } else if(vectorPairs.count(st.op)) {
+            if(!expectOperands(st, 2) || !vectorOperand(st, 0, rs1) || !vectorOperand(st, 1, rs2)) return false;
+            code.push_back(encodeR(vectorPairs.at(st.op), 0, rs1, rs2));
+        } else if(st.op == "VLD") {
+            // VLD v, (xN)+
+            std::string address = st.args.size() == 2 ? trim(st.args[1]) : "";
+            if(!expectOperands(st, 2) || !vectorOperand(st, 0, rd)) return false;
+            if(address.size() < 4 || address.front() != '(' || address.substr(address.size() - 2) != ")+" ||
+               (rs1 = parseRegister(address.substr(1, address.size() - 3))) <= 0) {
+                error(st, "VLD takes (xN)+ with N != 0");
+                return false;
+            }
+            code.push_back(encodeR(OP_ADD, 0, rd, rs1));
+        } else if(st.op == "VPOPC") {
+            if(!expectOperands(st, 2) || !registerOperand(st, 0, rd) || !vectorOperand(st, 1, rs1)) return false;
+            code.push_back(encodeR(OP_OR, 0, rd, rs1));
+        } else if(st.op == "VREDSUM" || st.op == "VLENB") {
+            if(!expectOperands(st, 1) || !registerOperand(st, 0, rd)) return false;
+            code.push_back(encodeR(OP_VCMPEQB, 0, rd, st.op == "VLENB" ? 1 : 0));
+        } else if(iType.count(st.op)) {
+            if(!expectOperands(st, 3) || !registerOperand(st, 0, rd) || !registerOperand(st, 1, rs1) ||
+               !valueOperand(st, st.args[2], value)) return false;
+            if(!fitsSigned(value, 4)) {
+                error(st, "immediate " + std::to_string(value) + " does not fit in 4 bits (use LI)");
+                return false;
+            }
+            if(st.op == "MULI" && value == 0) {
+                error(st, "MULI by 0 encodes BCNT");
+                return false;
+            }
+            if(st.op == "XORI" && rd == 0) {
+                error(st, "XORI into x0 encodes a system instruction");
+                return false;
+            }
+            code.push_back(encodeI(iType.at(st.op), rd, rs1, static_cast<int>(value)));
+        } else if(memory.count(st.op)) {
+            if(!expectOperands(st, 2) || !registerOperand(st, 0, rd) ||
+               !memoryOperand(st, st.args[1], rs1, value)) return false;
+            int scale = st.op == "LHB" ? 1 : 4;
+            if(value % scale != 0 || !fitsSigned(value / scale, 4)) {
+                error(st, "offset " + std::to_string(value) + " out of range for " + st.op);
+                return false;
+            }
+            code.push_back(encodeI(memory.at(st.op), rd, rs1, static_cast<int>(value / scale)));
+        } else if(branches.count(st.op)) {
+            if(!expectOperands(st, 3) || !registerOperand(st, 0, rs1) || !registerOperand(st, 1, rs2)) return false;
+            if(!st.relaxed) {
+                if(!offsetTo(st, st.args[2], st.address, 4, offset)) return false;
+                code.push_back(encodeI(branches.at(st.op), rs1, rs2, offset));
+            } else if(st.op == "BLT") {
+                // BLT to the far jump, else skip over it
+                if(!offsetTo(st, st.args[2], st.address + 4, 8, offset)) return false;
+                code.push_back(encodeI(OP_BLT, rs1, rs2, 1));
+                code.push_back(encodeJ(0, 1));
+                code.push_back(encodeJ(0, offset));
+            } else {
+                // Inverted condition skips the far jump
+                if(!offsetTo(st, st.args[2], st.address + 2, 8, offset)) return false;
+                code.push_back(encodeI(st.op == "BEQ" ? OP_BNE : OP_BEQ, rs1, rs2, 1));
+                code.push_back(encodeJ(0, offset));
+            }
+        } else if(st.op == "JAL") {
+            if(!expectOperands(st, 2) || !registerOperand(st, 0, rd) ||
+               !offsetTo(st, st.args[1], st.address, 8, offset)) return false;
+            code.push_back(encodeJ(rd, offset));
+        } else if(st.op == "BCNT") {
+            if(!expectOperands(st, 2) || !registerOperand(st, 0, rd) || !registerOperand(st, 1, rs1)) return false;
+            code.push_back(encodeI(OP_MULI, rd, rs1, 0));
+        } else if(st.op == "JR") {
+            if(!expectOperands(st, 1) || !registerOperand(st, 0, rs1)) return false;
+            code.push_back(encodeSys(SYS_JR, rs1));
+        } else if(st.op == "DOT4.B" || st.op == "DOT2.H") {
+            // MAC under MACMODE 1 / 2
+            if(!expectOperands(st, 3) || !registerOperand(st, 0, rd) || !registerOperand(st, 1, rs1) ||
+               !registerOperand(st, 2, rs2)) return false;
+            if(rd == 0) {
+                error(st, st.op + " into x0 encodes a SIMD instruction");
+                return false;
+            }
+            code.push_back(encodeR(OP_MAC, rd, rs1, rs2));
+        } else if(st.op == "MACMODE") {
+            if(!expectOperands(st, 1) || !valueOperand(st, st.args[0], value)) return false;
+            if(value < MAC_WORD || value > MAC_DOT2H) {
+                error(st, "MAC mode must be 0 (word), 1 (DOT4.B) or 2 (DOT2.H)");
+                return false;
+            }
+            code.push_back(encodeSys(SYS_MACMODE, static_cast<int>(value)));
+        } else if(st.op == "LOOP") {
+            if(!expectOperands(st, 2) || !registerOperand(st, 0, rs1) ||
+               !offsetTo(st, st.args[1], st.address, 8, offset)) return false;
+            if(offset < 1 || offset > MAX_LOOP_BODY) {
+                error(st, "LOOP body must be 1-" + std::to_string(MAX_LOOP_BODY) + " instructions");
+                return false;
+            }
+            code.push_back(encodeSys(SYS_LOOP + offset - 1, rs1));
+        } else if(st.op == "NOP") {
+            if(!expectOperands(st, 0)) return false;
+            code.push_back(encodeSys(SYS_NOP, 0));
+        } else if(st.op == "SLEEPM") {
+            if(!expectOperands(st, 1) || !valueOperand(st, st.args[0], value)) return false;
+            if(value < 0 || value > SLEEP_POWER_OFF) {
+                error(st, "sleep mode must be 0-15");
+                return false;
+            }
+            code.push_back(encodeSys(SYS_SLEEPM, static_cast<int>(value)));
+        } else if(st.op == "LI") {
+            if(!expectOperands(st, 2) || !registerOperand(st, 0, rd) || !valueOperand(st, st.args[1], value)) return false;
+            if(rd == 0) {
+                error(st, "LI into x0");
+                return false;
+            }
+            if(value < INT32_MIN || value > UINT32_MAX) {
+                error(st, "value does not fit in 32 bits");
+                return false;
+            }
+            if(st.size == 2) {
+                code.push_back(encodeI(OP_ADDI, rd, 0, static_cast<int>(value)));
+            } else if(st.size < 10) {
+                int64_t low = ((value + 8) & 0xF) - 8;
+                code.push_back(encodeI(OP_ADDI, rd, 0, static_cast<int>((value - low) / 16)));
+                code.push_back(encodeI(OP_MULI, rd, rd, 4));
+                code.push_back(encodeI(OP_MULI, rd, rd, 4));
+                if(low != 0) code.push_back(encodeI(OP_ADDI, rd, rd, static_cast<int>(low)));
+            } else {
+                // JAL leaves the literal's address in rd, which must be word aligned
+                uint32_t literal = static_cast<uint32_t>(value);
+                bool aligned = st.address % 4 == 0;
+                if(aligned) code.push_back(encodeSys(SYS_NOP, 0));
+                code.push_back(encodeJ(rd, aligned ? 2 : 3));
+                code.push_back(static_cast<uint16_t>(literal));
+                code.push_back(static_cast<uint16_t>(literal >> 16));
+                if(!aligned) code.push_back(0);
+                code.push_back(encodeI(OP_LW, rd, rd, 0));
+            }
+        } else {
+            error(st, "unknown instruction '" + st.op + "'");
+            return false;
+        }
+        return true;
+    }
+
+    void emit(const Statement& st, uint32_t base, std::vector<uint8_t>& bytes) {
+        uint32_t offset = st.address - base;
+        if(st.op.empty()) return;
+        if(st.op == ".ORG") {
+            int64_t target = 0;
+            std::string problem;
+            if(!expectOperands(st, 1)) return;
+            if(!evaluate(st.args[0], st.file, true, target, problem)) {
+                error(st, problem);
+            } else if(target != st.address) {
+                error(st, ".org would move backwards");
+            }
+            return;
+        }
+        if(st.op == ".ALIGN" || st.op == ".SPACE") {
+            int64_t value = 0;
+            std::string problem;
+            if(!expectOperands(st, 1)) return;
+            if(!evaluate(st.args[0], st.file, true, value, problem)) {
+                error(st, problem);
+            } else if(value <= 0 && st.op == ".ALIGN") {
+                error(st, ".align needs a positive boundary");
+            }
+            return;
+        }
+        if(st.op == ".WORD" || st.op == ".HALF" || st.op == ".BYTE") {
+            uint32_t width = st.op == ".WORD" ? 4 : st.op == ".HALF" ? 2 : 1;
+            if(st.address % width != 0) error(st, st.op + " data is not aligned (add .align)");
+            for(size_t i = 0; i < st.args.size(); i++) {
+                int64_t value = 0;
+                if(!valueOperand(st, st.args[i], value)) continue;
+                for(uint32_t b = 0; b < width; b++) {
+                    bytes[offset + width * i + b] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * b));
+                }
+            }
+            return;
+        }
+
+        std::vector<uint16_t> code;
+        if(st.address & 1) {
+            error(st, "instruction at odd address");
+            return;
+        }
+        if(!encode(st, code)) return;
+        if(code.size() * 2 != st.size) {
+            error(st, "internal error: size changed between passes");
+            return;
+        }
+        for(size_t i = 0; i < code.size(); i++) {
+            bytes[offset + 2 * i] = static_cast<uint8_t>(code[i]);
+            bytes[offset + 2 * i + 1] = static_cast<uint8_t>(code[i] >> 8);
+        }
+    }
+
+    std::string listingLine(const Statement& st, const std::vector<uint8_t>& bytes, uint32_t base) const {
+        char hex[32] = "";
+        size_t length = 0;
+        for(uint32_t i = 0; i < st.size && i < 6; i += 2) {
+            uint32_t at = st.address - base + i;
+            unsigned half = bytes[at] | (at + 1 < bytes.size() ? bytes[at + 1] << 8 : 0);
+            length += std::snprintf(hex + length, sizeof(hex) - length, "%04x ", half);
+        }
+        if(st.size > 6) std::snprintf(hex + length, sizeof(hex) - length, "...");
+        char line[64];
+        std::snprintf(line, sizeof(line), "%04x  %-19s ", st.address, hex);
+        return line + st.source;
+    }
+
+public:
+    bool addSource(const std::string& file, const std::string& text) {
+        size_t errorsBefore = messages.size();
+        size_t first = statements.size();
+        std::set<std::string> globals;
+        std::istringstream lines(text);
+        std::string line;
+        for(int number = 1; std::getline(lines, line); number++) {
+            parseLine(file, number, line, globals);
+        }
+
+        std::set<std::string> defined;
+        for(size_t i = first; i < statements.size(); i++) {
+            Statement& st = statements[i];
+            if(st.label.empty()) continue;
+            std::string name = st.label;
+            st.label = globals.count(name) ? name : scoped(file, name);
+            defined.insert(name);
+            if(constants.count(scoped(file, name)) || !definedSymbols.insert(st.label).second) {
+                error(st, "'" + name + "' is already defined");
+            }
+        }
+        for(const auto& name : globals) {
+            if(!defined.count(name)) error(file, 0, ".global '" + name + "' is not defined in this file");
+        }
+        return messages.size() == errorsBefore;
+    }
+
+    bool addFile(const std::string& path) {
+        std::ifstream in(path.c_str());
+        if(!in) {
+            messages.push_back(path + ": cannot open");
+            return false;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        return addSource(path, text.str());
+    }
+
+    // Lays out and encodes everything added so far at base. The entry
+    // point is the _start symbol if one is defined, otherwise base.
+    bool link(uint32_t base, Image& image) {
+        layout(base);
+        image = Image();
+        image.base = base;
+        uint32_t end = base;
+        for(const auto& st : statements) end = std::max(end, st.address + st.size);
+        if(end > ADDRESS_SPACE) error("link", 0, "image ends at " + std::to_string(end) + ", past the end of memory");
+        image.bytes.assign(end - base, 0);
+
+        for(const auto& st : statements) {
+            emit(st, base, image.bytes);
+            if(!st.source.empty()) image.listing.push_back(listingLine(st, image.bytes, base));
+        }
+        image.symbols.insert(labels.begin(), labels.end());
+        auto start = labels.find("_start");
+        image.entry = start != labels.end() ? start->second : base;
+        return messages.empty();
+    }
+
+    const std::vector<std::string>& errors() const { return messages; }
+};
+
+} // namespace isa
+
+#endif
@@ -5,6 +5,11 @@
 #include <random>
 #include <chrono>
 #include <thread> 
+#include <sstream>
+#include "report_sink.h"
+#include "energy_model.h"
+#include "op_trace.h"
+#include "cli_args.h"
 
 class BiometricSecuritySim {
 private:
@@ -14,11 +19,22 @@ private:
         std::vector<std::string> trustedDevices;
     };
     
+    // Compact result of one authentication decision
+    struct AuthResult {
+        std::string userId;
+        bool userFound;
+        bool authenticated;
+        bool trustedEnvironment;
+        const char* authMethod;
+        double durationUs;
+    };
+    
     std::map<std::string, UserProfile> userDatabase;
     std::vector<std::string> nearbyDevices;
+    ReportSink report;
     
 public:
-    BiometricSecuritySim() {
+    BiometricSecuritySim() : report(std::cout, true) {
         initializeUserDatabase();
     }
     
@@ -41,13 +57,19 @@ public:
         std::cout << "\n=== User Authentication Test ===" << std::endl;
         
         scanNearbyDevices();
-        std::cout << std::endl;
+        report.submit("\n");
         
         // Test authentication for different users
+        energy::Snapshot energyBefore = energy::snapshot();
         authenticateUser("thabo");
         authenticateUser("matseliso");
         authenticateUser("ntate_john");
         authenticateUser("unknown_user"); // Test non-existent user
+        energy::Snapshot authEnergy = energy::snapshot().since(energyBefore);
+        report.flush();
+        
+        std::cout << "\n🔋 Energy per authentication: " << authEnergy.totalMilliJoules() / 4 << " mJ" << std::endl;
+        std::cout << authEnergy.breakdown(4);
     }
     
     void testContextAwareness() {
@@ -58,7 +80,7 @@ public:
         std::vector<std::string> environments = {"Home", "Office", "Public", "Unknown"};
         
         for(const auto& env : environments) {
-            std::cout << "\n--- Testing " << env << " Environment ---" << std::endl;
+            report.submit("\n--- Testing " + env + " Environment ---\n");
             
             // Simulate different device scans for each environment
             if(env == "Home") {
@@ -71,15 +93,12 @@ public:
                 nearbyDevices = {"strange_device", "unknown_network"};
             }
             
-            std::cout << "Nearby devices: ";
-            for(const auto& device : nearbyDevices) {
-                std::cout << device << " ";
-            }
-            std::cout << std::endl;
+            report.submit(renderDevices("Nearby devices: "));
             
             // Test authentication in this context
             authenticateUser("thabo");
         }
+        report.flush();
     }
     
     void stressTest() {
@@ -87,6 +106,7 @@ public:
         std::cout << "Testing system under load..." << std::endl;
         
         scanNearbyDevices();
+        report.flush();
         int attempts = 5;
         int successCount = 0;
         
@@ -116,63 +136,129 @@ public:
         std::cout << "• Random memory access patterns" << std::endl;
         std::cout << "• Decision logic intensive" << std::endl;
     }
+    
+    void switchOutputFormat() {
+        report.toggleFormat();
+        std::cout << "Authentication reports now rendered as " << report.formatName() << std::endl;
+    }
+    
+    // Records isTrustedEnvironment for each profile in turn against a
+    // rotating set of nearby devices, for the processor simulator's
+    // trace-driven pipeline (op_trace.h)
+    bool captureTrace(const std::string& path, int calls) {
+        const std::vector<std::string> pool = {"home_bt", "unknown_device", "office_wifi",
+                                               "car_bt", "smart_tv", "personal_device"};
+        optrace::Recorder recorder;
+        auto user = userDatabase.begin();
+        for(int call = 0; call < calls; call++) {
+            nearbyDevices.clear();
+            for(size_t i = 0; i < 3; i++) {
+                nearbyDevices.push_back(pool[(call + 2 * i) % pool.size()]);
+            }
+            optrace::Capture capture(recorder);
+            isTrustedEnvironment(user->second);
+            if(++user == userDatabase.end()) user = userDatabase.begin();
+        }
+        std::string error;
+        if(!recorder.save(path, error)) {
+            std::cerr << "❌ " << error << std::endl;
+            return false;
+        }
+        std::cout << "Traced " << calls << " calls: " << recorder.recordCount() << " operations in "
+                  << recorder.byteCount() << " bytes -> " << path << std::endl;
+        return true;
+    }
 
 private:
     void scanNearbyDevices() {
         nearbyDevices = {"home_bt", "unknown_device", "office_wifi", "car_bt"};
-        std::cout << "Scanning nearby devices... Found: ";
-        for(const auto& device : nearbyDevices) {
-            std::cout << device << " ";
-        }
-        std::cout << std::endl;
+        energy::charge(energy::BLE_SCAN_WINDOW, 3);
+        report.submit(renderDevices("Scanning nearby devices... Found: "));
     }
     
     void authenticateUser(const std::string& userId) {
+        report.submit(renderAuthResult(authenticate(userId)));
+    }
+    
+    // Decision path only; the result is rendered separately
+    AuthResult authenticate(const std::string& userId) {
+        energy::Snapshot work = energy::threadSnapshot();
         auto start = std::chrono::high_resolution_clock::now();
         
-        if(userDatabase.find(userId) == userDatabase.end()) {
-            std::cout << "❌ User '" << userId << "' not found in database!" << std::endl;
-            return;
+        AuthResult result = {userId, false, false, false, "", 0.0};
+        auto user = userDatabase.find(userId);
+        energy::charge(energy::DRAM_ACCESS, 8); // profile lookup: a few tree nodes off-chip
+        if(user != userDatabase.end()) {
+            const UserProfile& profile = user->second;
+            result.userFound = true;
+            
+            bool voiceAuth = authenticateVoice(profile.voicePrintHash);
+            result.trustedEnvironment = isTrustedEnvironment(profile);
+            
+            if(voiceAuth) {
+                result.authenticated = true;
+                result.authMethod = "Voice";
+            } else {
+                // Fallback to PIN verification
+                result.authenticated = verifyPIN(profile.pin);
+                result.authMethod = "PIN";
+            }
         }
         
-        const UserProfile& profile = userDatabase[userId];
-        
-        bool voiceAuth = authenticateVoice(profile.voicePrintHash);
-        bool trustedEnvironment = isTrustedEnvironment(profile);
-        
-        bool authenticated = false;
-        std::string authMethod = "";
-        std::string contextInfo = "";
-        
-        if(voiceAuth && trustedEnvironment) {
-            authenticated = true;
-            authMethod = "Voice";
-            contextInfo = " (Trusted Environment)";
-        } else if(voiceAuth) {
-            authenticated = true;
-            authMethod = "Voice";
-        } else {
-            // Fallback to PIN verification
-            authenticated = verifyPIN(profile.pin);
-            authMethod = "PIN";
+        auto end = std::chrono::high_resolution_clock::now();
+        result.durationUs = std::chrono::duration<double, std::micro>(end - start).count();
+        energy::chargeCore(energy::threadSnapshot().since(work));
+        return result;
+    }
+    
+    std::string renderDevices(const std::string& label) const {
+        if(report.format == ReportSink::JSON) {
+            return "{\"nearbyDevices\":" + jsonStringArray(nearbyDevices) + "}\n";
+        }
+        std::string line = label;
+        for(const auto& device : nearbyDevices) {
+            line += device + " ";
+        }
+        return line + "\n";
+    }
+    
+    std::string renderAuthResult(const AuthResult& result) const {
+        std::ostringstream out;
+        if(report.format == ReportSink::JSON) {
+            out << "{\"user\":" << jsonString(result.userId)
+                << ",\"found\":" << (result.userFound ? "true" : "false");
+            if(result.userFound) {
+                out << ",\"authenticated\":" << (result.authenticated ? "true" : "false")
+                    << ",\"method\":" << jsonString(result.authMethod)
+                    << ",\"trustedEnvironment\":" << (result.trustedEnvironment ? "true" : "false")
+                    << ",\"durationUs\":" << result.durationUs;
+            }
+            out << "}\n";
+            return out.str();
         }
         
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        if(!result.userFound) {
+            out << "❌ User '" << result.userId << "' not found in database!\n";
+            return out.str();
+        }
         
-        std::cout << "👤 " << userId << ": ";
-        if(authenticated) {
-            std::cout << "✅ AUTH_SUCCESS";
+        out << "👤 " << result.userId << ": ";
+        if(result.authenticated) {
+            out << "✅ AUTH_SUCCESS";
         } else {
-            std::cout << "❌ AUTH_FAILED";
+            out << "❌ AUTH_FAILED";
+        }
+        out << " via " << result.authMethod;
+        if(result.authenticated && result.trustedEnvironment && std::string(result.authMethod) == "Voice") {
+            out << " (Trusted Environment)";
         }
-        std::cout << " via " << authMethod << contextInfo;
-        std::cout << " [" << duration.count() << "ms]" << std::endl;
+        out << " [" << result.durationUs << "μs]\n";
         
         // Check if within acceptable latency
-        if(duration.count() > 2000) {
-            std::cout << "   ⚠️  Slow authentication (>2s)" << std::endl;
+        if(result.durationUs > 2000000) {
+            out << "   ⚠️  Slow authentication (>2s)\n";
         }
+        return out.str();
     }
     
     bool quickAuthTest() {
@@ -184,6 +270,13 @@ private:
     }
     
     bool authenticateVoice(const std::string& storedVoicePrint) {
+        // One second of speech: 16 feature frames scored against a
+        // 256-element voiceprint fetched from off-chip memory
+        energy::charge(energy::AUDIO_CAPTURE_MS, 1000);
+        energy::charge(energy::FEATURE_FRAME, 16);
+        energy::charge(energy::MAC_OP, 16 * 256);
+        energy::charge(energy::DRAM_ACCESS, 256);
+        
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_real_distribution<float> dis(0.0f, 1.0f);
@@ -191,17 +284,29 @@ private:
     }
     
     bool isTrustedEnvironment(const UserProfile& profile) {
-        for(const auto& trustedDevice : profile.trustedDevices) {
-            for(const auto& nearbyDevice : nearbyDevices) {
-                if(trustedDevice == nearbyDevice) {
+        optrace::Recorder* trace = optrace::recorder();
+        if(trace) trace->mark(optrace::KERNEL_TRUSTED_ENVIRONMENT);
+        for(size_t t = 0; t < profile.trustedDevices.size(); t++) {
+            const std::string& trustedDevice = profile.trustedDevices[t];
+            for(size_t n = 0; n < nearbyDevices.size(); n++) {
+                energy::charge(energy::SRAM_ACCESS, 4); // short string compare
+                if(trace) {
+                    trace->load(trustedDevice.data());
+                    trace->load(nearbyDevices[n].data());
+                }
+                if(optrace::compareBranch(trace, 0, trustedDevice == nearbyDevices[n])) {
                     return true;
                 }
+                if(trace) trace->branch(1, n + 1 < nearbyDevices.size());
             }
+            if(trace) trace->branch(2, t + 1 < profile.trustedDevices.size());
         }
         return false;
     }
     
     bool verifyPIN(const std::string& correctPIN) {
+        energy::charge(energy::SRAM_ACCESS, 8);
+        
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_real_distribution<float> dis(0.0f, 1.0f);
@@ -216,13 +321,24 @@ void displayMenu() {
     std::cout << "1. Test User Authentication" << std::endl;
     std::cout << "2. Test Context Awareness" << std::endl;
     std::cout << "3. Stress Test" << std::endl;
-    std::cout << "4. Show Workload Information" << std::endl;
-    std::cout << "5. Exit" << std::endl;
+    std::cout << "4. Switch Output Format (text/JSON)" << std::endl;
+    std::cout << "5. Show Workload Information" << std::endl;
+    std::cout << "6. Exit" << std::endl;
     std::cout << "==========================================" << std::endl;
-    std::cout << "Choose an option (1-5): ";
+    std::cout << "Choose an option (1-6): ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if(argc > 1) {
+        int calls = 1000;
+        if(std::string(argv[1]) != "--trace" || argc < 3 || argc > 4 || (argc > 3 && !cli::parseCount(argv[3], calls))) {
+            std::cerr << "Usage: " << argv[0] << " [--trace PATH [CALLS]]  (CALLS a positive integer)" << std::endl;
+            return 2;
+        }
+        BiometricSecuritySim securitySim;
+        return securitySim.captureTrace(argv[2], calls) ? 0 : 1;
+    }
+    
     BiometricSecuritySim securitySim;
     int choice;
     
@@ -244,15 +360,18 @@ int main() {
                 securitySim.stressTest();
                 break;
             case 4:
-                securitySim.showWorkloadInfo();
+                securitySim.switchOutputFormat();
                 break;
             case 5:
+                securitySim.showWorkloadInfo();
+                break;
+            case 6:
                 std::cout << "Exiting Biometric Security Simulator. Goodbye!" << std::endl;
                 break;
             default:
-                std::cout << "Invalid option! Please choose 1-5." << std::endl;
+                std::cout << "Invalid option! Please choose 1-6." << std::endl;
         }
-    } while(choice != 5);
+    } while(choice != 6);
     
     return 0;
 }
@@ -0,0 +1,200 @@
+#ifndef BRANCH_PREDICTOR_H
+#define BRANCH_PREDICTOR_H
+
+#include <vector>
+#include <cstdint>
+
+// Direction predictors for the pipeline model's fetch stage. Branch and JAL
+// targets are PC-relative, so fetch computes them from the instruction word
+// and only the direction of BEQ/BNE/BLT needs predicting; JR is never
+// predicted.
+//
+// Tables are read at fetch and trained when the branch resolves in EX. The
+// global history only holds resolved branches (no speculative update), which
+// is what a cheap in-order core would build. Fetch records history() next to
+// each prediction and hands it back to update(), so a branch trains the entry
+// it was predicted from even if an older branch resolved in between.
+namespace isa {
+
+class BranchPredictor {
+public:
+    virtual ~BranchPredictor() {}
+    virtual const char* name() const = 0;
+    virtual bool predict(uint32_t pc, uint32_t target) = 0;
+    virtual void update(uint32_t pc, uint32_t target, bool taken, uint32_t predictedHistory) = 0;
+    virtual uint32_t storageBits() const = 0;
+
+    // The global history a prediction made now would index with
+    virtual uint32_t history() const { return 0; }
+
+    // Whether fetch follows JAL (false only for the spec's no-predictor baseline)
+    virtual bool followsJumps() const { return true; }
+};
+
+// The Microarchitecture Specification's baseline: fetch runs straight on
+class StaticNotTaken : public BranchPredictor {
+public:
+    const char* name() const { return "static not-taken"; }
+    bool predict(uint32_t, uint32_t) { return false; }
+    void update(uint32_t, uint32_t, bool, uint32_t) {}
+    uint32_t storageBits() const { return 0; }
+    bool followsJumps() const { return false; }
+};
+
+// Backward taken, forward not taken: loops predict well for free
+class Btfn : public BranchPredictor {
+public:
+    const char* name() const { return "BTFN"; }
+    bool predict(uint32_t pc, uint32_t target) { return target <= pc; }
+    void update(uint32_t, uint32_t, bool, uint32_t) {}
+    uint32_t storageBits() const { return 0; }
+};
+
+inline void trainCounter(uint8_t& counter, bool taken, uint8_t max) {
+    if(taken && counter < max) counter++;
+    else if(!taken && counter > 0) counter--;
+}
+
+// 2-bit saturating counters indexed by pc
+class Bimodal : public BranchPredictor {
+private:
+    std::vector<uint8_t> counters;
+
+    uint8_t& counter(uint32_t pc) { return counters[(pc >> 1) & (counters.size() - 1)]; }
+
+public:
+    explicit Bimodal(uint32_t entries = 256) : counters(entries, 1) {}
+    const char* name() const { return "bimodal"; }
+    bool predict(uint32_t pc, uint32_t) { return counter(pc) >= 2; }
+    void update(uint32_t pc, uint32_t, bool taken, uint32_t) { trainCounter(counter(pc), taken, 3); }
+    uint32_t storageBits() const { return 2 * static_cast<uint32_t>(counters.size()); }
+};
+
+// 2-bit counters indexed by pc xor global history
+class Gshare : public BranchPredictor {
+private:
+    std::vector<uint8_t> counters;
+    uint32_t historyBits;
+    uint32_t globalHistory;
+
+    uint8_t& counter(uint32_t pc, uint32_t history) { return counters[((pc >> 1) ^ history) & (counters.size() - 1)]; }
+
+public:
+    Gshare(uint32_t entries = 256, uint32_t bits = 8) : counters(entries, 1), historyBits(bits), globalHistory(0) {}
+    const char* name() const { return "gshare"; }
+    bool predict(uint32_t pc, uint32_t) { return counter(pc, globalHistory) >= 2; }
+    uint32_t history() const { return globalHistory; }
+
+    void update(uint32_t pc, uint32_t, bool taken, uint32_t predictedHistory) {
+        trainCounter(counter(pc, predictedHistory), taken, 3);
+        globalHistory = ((globalHistory << 1) | (taken ? 1 : 0)) & ((1u << historyBits) - 1);
+    }
+
+    uint32_t storageBits() const { return 2 * static_cast<uint32_t>(counters.size()) + historyBits; }
+};
+
+// A bimodal base plus three tagged tables on 4, 8 and 16 bits of global
+// history. The longest matching table provides the prediction; a
+// misprediction allocates an entry in a longer table whose useful bit is
+// clear, and useful bits are cleared every 1024 updates.
+class TageLite : public BranchPredictor {
+private:
+    static const int TABLES = 3;
+    static const uint32_t TAG_BITS = 7;
+
+    struct Entry {
+        uint8_t tag;
+        uint8_t counter;   // 3 bits, taken when >= 4
+        uint8_t useful;    // 1 bit
+    };
+
+    std::vector<uint8_t> base;
+    std::vector<Entry> tables[TABLES];
+    uint32_t historyLength[TABLES];
+    uint32_t globalHistory;
+    uint32_t updates;
+
+    static uint32_t folded(uint32_t history, uint32_t length, uint32_t bits) {
+        uint32_t value = history & ((1u << length) - 1);
+        uint32_t result = 0;
+        for(; value != 0; value >>= bits) result ^= value & ((1u << bits) - 1);
+        return result;
+    }
+
+    uint32_t index(int table, uint32_t pc, uint32_t history) const {
+        uint32_t bits = 0;
+        while((1u << bits) < tables[table].size()) bits++;
+        return ((pc >> 1) ^ folded(history, historyLength[table], bits) ^ (table << 2)) & (tables[table].size() - 1);
+    }
+
+    uint8_t tag(int table, uint32_t pc, uint32_t history) const {
+        return static_cast<uint8_t>(((pc >> 1) ^ (folded(history, historyLength[table], TAG_BITS) << 1)) & ((1u << TAG_BITS) - 1));
+    }
+
+    uint8_t& baseCounter(uint32_t pc) { return base[(pc >> 1) & (base.size() - 1)]; }
+
+    // Longest matching table, or -1 for the base predictor
+    int provider(uint32_t pc, int below, uint32_t history) const {
+        for(int t = below - 1; t >= 0; t--) {
+            if(tables[t][index(t, pc, history)].tag == tag(t, pc, history)) return t;
+        }
+        return -1;
+    }
+
+    bool prediction(int table, uint32_t pc, uint32_t history) {
+        return table < 0 ? baseCounter(pc) >= 2 : tables[table][index(table, pc, history)].counter >= 4;
+    }
+
+public:
+    explicit TageLite(uint32_t baseEntries = 256, uint32_t taggedEntries = 64)
+        : base(baseEntries, 1), globalHistory(0), updates(0) {
+        for(int t = 0; t < TABLES; t++) {
+            tables[t].assign(taggedEntries, Entry{0, 4, 0});
+            historyLength[t] = 4u << t;
+        }
+    }
+
+    const char* name() const { return "TAGE-lite"; }
+
+    bool predict(uint32_t pc, uint32_t) { return prediction(provider(pc, TABLES, globalHistory), pc, globalHistory); }
+    uint32_t history() const { return globalHistory; }
+
+    void update(uint32_t pc, uint32_t, bool taken, uint32_t predictedHistory) {
+        int used = provider(pc, TABLES, predictedHistory);
+        bool predicted = prediction(used, pc, predictedHistory);
+        if(used >= 0) {
+            Entry& entry = tables[used][index(used, pc, predictedHistory)];
+            bool alternate = prediction(provider(pc, used, predictedHistory), pc, predictedHistory);
+            if(alternate != predicted) entry.useful = predicted == taken ? 1 : 0;
+            trainCounter(entry.counter, taken, 7);
+        } else {
+            trainCounter(baseCounter(pc), taken, 3);
+        }
+
+        if(predicted != taken) {
+            for(int t = used + 1; t < TABLES; t++) {
+                Entry& entry = tables[t][index(t, pc, predictedHistory)];
+                if(entry.useful == 0) {
+                    entry = Entry{tag(t, pc, predictedHistory), static_cast<uint8_t>(taken ? 4 : 3), 0};
+                    break;
+                }
+            }
+        }
+        if(++updates % 1024 == 0) {
+            for(auto& table : tables) {
+                for(auto& entry : table) entry.useful = 0;
+            }
+        }
+        globalHistory = (globalHistory << 1) | (taken ? 1 : 0);
+    }
+
+    uint32_t storageBits() const {
+        uint32_t bits = 2 * static_cast<uint32_t>(base.size()) + historyLength[TABLES - 1];
+        for(const auto& table : tables) bits += static_cast<uint32_t>(table.size()) * (TAG_BITS + 3 + 1);
+        return bits;
+    }
+};
+
+} // namespace isa
+
+#endif
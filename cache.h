@@ -0,0 +1,428 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+// Timing model of the instruction and data memory: split L1I/L1D, an
+// optional unified L2 and a fixed DRAM latency. Only tags are kept; data
+// always comes from the Machine, so the caches decide how long an access
+// takes and never what it returns.
+//
+// Caches are write-back and write-allocate. A dirty L1 victim is written
+// to the L2 (or DRAM) through a write buffer, so it costs traffic but no
+// latency on the access that evicted it.
+//
+// For a multicore configuration each core keeps its own hierarchy for the
+// private L1I/L1D and joins a SnoopingBus, which owns the shared L2. The
+// L1Ds then follow MSI: a dirty line is Modified, a clean one Shared.
+// Reads that miss, writes that miss and writes to a Shared line go on the
+// bus as BusRd, BusRdX and BusUpgr; the other L1Ds snoop them, a Modified
+// copy supplies the line and is written back, and BusRdX/BusUpgr
+// invalidate every other copy. The bus carries one transaction at a time,
+// so a request may first wait for it.
+namespace isa {
+
+enum Replacement { REPLACE_LRU, REPLACE_FIFO, REPLACE_RANDOM };
+
+// MSI state of an L1D line on a snooping bus
+enum LineState { LINE_INVALID, LINE_SHARED, LINE_MODIFIED };
+
+inline const char* replacementName(Replacement policy) {
+    return policy == REPLACE_LRU ? "LRU" : policy == REPLACE_FIFO ? "FIFO" : "random";
+}
+
+struct CacheConfig {
+    uint32_t sizeBytes;
+    uint32_t associativity;
+    uint32_t lineBytes;
+    Replacement replacement;
+    int hitLatency;         // cycles, including the pipeline stage's own cycle for L1
+
+    CacheConfig(uint32_t size = 1024, uint32_t ways = 2, uint32_t line = 16,
+                Replacement policy = REPLACE_LRU, int latency = 1)
+        : sizeBytes(size), associativity(ways), lineBytes(line), replacement(policy), hitLatency(latency) {}
+};
+
+struct CacheStats {
+    uint64_t accesses;
+    uint64_t misses;
+    uint64_t writebacks;
+
+    CacheStats() : accesses(0), misses(0), writebacks(0) {}
+
+    double missRate() const {
+        return accesses > 0 ? static_cast<double>(misses) / accesses : 0.0;
+    }
+};
+
+class Cache {
+private:
+    struct Line {
+        uint32_t tag;
+        bool valid;
+        bool dirty;
+        uint64_t stamp;     // last use (LRU) or fill time (FIFO)
+    };
+
+    CacheConfig config;
+    uint32_t sets;
+    uint32_t lineShift;
+    std::vector<Line> lines;
+    uint64_t clock;
+    uint32_t randomState;
+
+    Line* find(uint32_t address) {
+        uint32_t block = address >> lineShift;
+        Line* way = &lines[static_cast<size_t>(block % sets) * config.associativity];
+        for(uint32_t i = 0; i < config.associativity; i++) {
+            if(way[i].valid && way[i].tag == block / sets) return &way[i];
+        }
+        return nullptr;
+    }
+
+public:
+    CacheStats stats;
+
+    explicit Cache(const CacheConfig& cacheConfig) : config(cacheConfig), lineShift(0), clock(0), randomState(65) {
+        while((1u << lineShift) < config.lineBytes) lineShift++;
+        sets = std::max<uint32_t>(1, config.sizeBytes / (config.lineBytes * config.associativity));
+        lines.resize(static_cast<size_t>(sets) * config.associativity);
+        invalidateAll();
+    }
+
+    const CacheConfig& settings() const { return config; }
+
+    void invalidateAll() {
+        for(auto& line : lines) line = Line{0, false, false, 0};
+    }
+
+    // Drops any line holding address without writing it back (the
+    // backing memory was just overwritten behind the cache); returns true
+    // if it was dirty
+    bool invalidate(uint32_t address) {
+        Line* line = find(address);
+        if(line == nullptr) return false;
+        line->valid = false;
+        return line->dirty;
+    }
+
+    LineState state(uint32_t address) {
+        Line* line = find(address);
+        return line == nullptr ? LINE_INVALID : line->dirty ? LINE_MODIFIED : LINE_SHARED;
+    }
+
+    // Modified -> Shared after a snooped read; returns true if the line was
+    // dirty and so has to be written back
+    bool downgrade(uint32_t address) {
+        Line* line = find(address);
+        if(line == nullptr || !line->dirty) return false;
+        line->dirty = false;
+        return true;
+    }
+
+    // Returns true on a hit. On a miss the line is filled; if that evicts a
+    // dirty line, writeback is set and victim holds its address.
+    bool access(uint32_t address, bool write, bool& writeback, uint32_t& victim) {
+        uint32_t block = address >> lineShift;
+        uint32_t set = block % sets;
+        uint32_t tag = block / sets;
+        Line* way = &lines[static_cast<size_t>(set) * config.associativity];
+        stats.accesses++;
+        clock++;
+        writeback = false;
+
+        for(uint32_t i = 0; i < config.associativity; i++) {
+            if(way[i].valid && way[i].tag == tag) {
+                if(config.replacement == REPLACE_LRU) way[i].stamp = clock;
+                way[i].dirty = way[i].dirty || write;
+                return true;
+            }
+        }
+
+        stats.misses++;
+        uint32_t chosen = 0;
+        bool found = false;
+        for(uint32_t i = 0; i < config.associativity && !found; i++) {
+            if(!way[i].valid) {
+                chosen = i;
+                found = true;
+            }
+        }
+        if(!found && config.replacement == REPLACE_RANDOM) {
+            randomState ^= randomState << 13;
+            randomState ^= randomState >> 17;
+            randomState ^= randomState << 5;
+            chosen = randomState % config.associativity;
+        } else if(!found) {
+            for(uint32_t i = 1; i < config.associativity; i++) {
+                if(way[i].stamp < way[chosen].stamp) chosen = i;
+            }
+        }
+
+        Line& line = way[chosen];
+        if(line.valid && line.dirty) {
+            writeback = true;
+            victim = (line.tag * sets + set) << lineShift;
+            stats.writebacks++;
+        }
+        line = Line{tag, true, write, clock};
+        return false;
+    }
+};
+
+struct HierarchyConfig {
+    CacheConfig l1i;
+    CacheConfig l1d;
+    bool useL2;
+    CacheConfig l2;
+    int dramLatency;
+
+    // 1KB L1I, 2KB L1D, 16KB L2, 40-cycle DRAM
+    HierarchyConfig()
+        : l1i(1024, 2, 16, REPLACE_LRU, 1), l1d(2048, 2, 16, REPLACE_LRU, 1),
+          useL2(true), l2(16384, 4, 32, REPLACE_LRU, 6), dramLatency(40) {}
+};
+
+// Bus occupancy in cycles: the address phase alone (BusUpgr) or with a
+// line transferred
+struct BusConfig {
+    int addressCycles;
+    int lineCycles;
+
+    BusConfig() : addressCycles(1), lineCycles(4) {}
+};
+
+struct BusStats {
+    uint64_t reads;             // BusRd
+    uint64_t readExclusives;    // BusRdX
+    uint64_t upgrades;          // BusUpgr
+    uint64_t invalidations;     // copies dropped in other L1Ds
+    uint64_t interventions;     // Modified copies that supplied a line
+    uint64_t writebacks;        // lines written back to the L2 over the bus
+    uint64_t busyCycles;
+    uint64_t waitCycles;        // cycles requests waited for the bus
+
+    BusStats() : reads(0), readExclusives(0), upgrades(0), invalidations(0), interventions(0),
+                 writebacks(0), busyCycles(0), waitCycles(0) {}
+
+    uint64_t coherenceMessages() const {
+        return invalidations + interventions;
+    }
+};
+
+enum BusRequest { BUS_READ, BUS_READ_EXCLUSIVE, BUS_UPGRADE };
+
+class SnoopingBus {
+private:
+    HierarchyConfig config;
+    BusConfig busConfig;
+    std::vector<Cache*> l1ds;
+    uint64_t freeAt;
+
+    // Waits for the bus and holds it for cycles; returns the total
+    int arbitrate(int cycles) {
+        uint64_t start = std::max(now, freeAt);
+        stats.waitCycles += start - now;
+        stats.busyCycles += cycles;
+        freeAt = start + cycles;
+        return static_cast<int>(start - now) + cycles;
+    }
+
+    int memory(uint32_t address, bool write) {
+        if(!config.useL2) {
+            if(write) dramWrites++;
+            else dramReads++;
+            return config.dramLatency;
+        }
+        bool writeback;
+        uint32_t victim;
+        bool hit = l2.access(address, write, writeback, victim);
+        if(writeback) dramWrites++;
+        if(hit) return config.l2.hitLatency;
+        if(!write) dramReads++;
+        return config.l2.hitLatency + config.dramLatency;
+    }
+
+public:
+    Cache l2;
+    BusStats stats;
+    uint64_t now;               // set by whoever clocks the cores
+    uint64_t dramReads;
+    uint64_t dramWrites;
+
+    SnoopingBus(const HierarchyConfig& hierarchyConfig, const BusConfig& settings)
+        : config(hierarchyConfig), busConfig(settings), freeAt(0), l2(config.l2), now(0),
+          dramReads(0), dramWrites(0) {}
+
+    // Adds a core's L1D to the snoop set; returns the core's index
+    int join(Cache& l1d) {
+        l1ds.push_back(&l1d);
+        return static_cast<int>(l1ds.size()) - 1;
+    }
+
+    // Cycles for core's request for the line holding address, after the
+    // other L1Ds have snooped it
+    int request(int core, uint32_t address, BusRequest kind) {
+        bool supplied = false;
+        for(size_t other = 0; other < l1ds.size(); other++) {
+            if(static_cast<int>(other) == core) continue;
+            Cache& peer = *l1ds[other];
+            if(kind == BUS_READ) {
+                supplied = peer.downgrade(address) || supplied;
+            } else if(peer.state(address) != LINE_INVALID) {
+                supplied = peer.invalidate(address) || supplied;
+                stats.invalidations++;
+            }
+        }
+        if(kind == BUS_UPGRADE) {
+            stats.upgrades++;
+            return arbitrate(busConfig.addressCycles);
+        }
+        if(kind == BUS_READ) stats.reads++;
+        else stats.readExclusives++;
+        if(supplied) {
+            // The owner puts the line on the bus and the L2 takes a copy
+            stats.interventions++;
+            stats.writebacks++;
+            memory(address, true);
+            return arbitrate(busConfig.addressCycles + busConfig.lineCycles);
+        }
+        int wait = arbitrate(busConfig.addressCycles + busConfig.lineCycles);
+        return wait + memory(address, false);
+    }
+
+    // A dirty L1 victim, through the write buffer: bus time but no latency
+    void writeBack(uint32_t address) {
+        stats.writebacks++;
+        arbitrate(busConfig.lineCycles);
+        memory(address, true);
+    }
+};
+
+class MemoryHierarchy {
+private:
+    HierarchyConfig config;
+    SnoopingBus* bus;
+    int core;
+
+    // Cycles to bring a line missing in L1 from further out
+    int fill(uint32_t address) {
+        if(bus != nullptr) return bus->request(core, address, BUS_READ);
+        if(!config.useL2) {
+            dramReads++;
+            return config.dramLatency;
+        }
+        bool writeback;
+        uint32_t victim;
+        if(l2.access(address, false, writeback, victim)) return config.l2.hitLatency;
+        if(writeback) dramWrites++;
+        dramReads++;
+        return config.l2.hitLatency + config.dramLatency;
+    }
+
+    void writeBack(uint32_t address) {
+        if(bus != nullptr) {
+            bus->writeBack(address);
+            return;
+        }
+        if(!config.useL2) {
+            dramWrites++;
+            return;
+        }
+        bool writeback;
+        uint32_t victim;
+        l2.access(address, true, writeback, victim);
+        if(writeback) dramWrites++;
+    }
+
+    int lookup(Cache& l1, uint32_t address, bool write) {
+        bool writeback;
+        uint32_t victim;
+        if(bus != nullptr && &l1 == &l1d) return coherentLookup(address, write);
+        if(l1.access(address, write, writeback, victim)) return l1.settings().hitLatency;
+        if(writeback) writeBack(victim);
+        return l1.settings().hitLatency + fill(address);
+    }
+
+    // L1D under MSI: Shared serves reads, Modified reads and writes, and
+    // anything else goes on the bus
+    int coherentLookup(uint32_t address, bool write) {
+        LineState state = l1d.state(address);
+        bool writeback;
+        uint32_t victim;
+        l1d.access(address, write, writeback, victim);
+        if(writeback) writeBack(victim);
+        int cycles = l1d.settings().hitLatency;
+        if(state == LINE_INVALID) return cycles + bus->request(core, address, write ? BUS_READ_EXCLUSIVE : BUS_READ);
+        if(state == LINE_SHARED && write) return cycles + bus->request(core, address, BUS_UPGRADE);
+        return cycles;
+    }
+
+public:
+    Cache l1i;
+    Cache l1d;
+    Cache l2;
+    uint64_t dramReads;
+    uint64_t dramWrites;
+    uint64_t fetchCycles;
+    uint64_t dataCycles;
+
+    explicit MemoryHierarchy(const HierarchyConfig& hierarchyConfig)
+        : config(hierarchyConfig), bus(nullptr), core(0), l1i(config.l1i), l1d(config.l1d), l2(config.l2),
+          dramReads(0), dramWrites(0), fetchCycles(0), dataCycles(0) {}
+
+    const HierarchyConfig& settings() const { return config; }
+
+    // Makes the L1s private to one core of a multicore system: misses,
+    // write-backs and L1D coherence go through shared, whose L2 replaces
+    // this hierarchy's own
+    void joinBus(SnoopingBus& shared) {
+        bus = &shared;
+        core = shared.join(l1d);
+    }
+
+    // Cycles for an instruction fetch or a data access, including the
+    // L1 hit cycle
+    int fetch(uint32_t address) {
+        int cycles = lookup(l1i, address, false);
+        fetchCycles += cycles;
+        return cycles;
+    }
+
+    int data(uint32_t address, bool write) {
+        int cycles = lookup(l1d, address, write);
+        dataCycles += cycles;
+        return cycles;
+    }
+
+    // The host wrote memory directly (the DMA path): cached copies are stale
+    void invalidate(uint32_t address, uint32_t bytes) {
+        uint32_t step = std::min(config.l1i.lineBytes, config.l1d.lineBytes);
+        if(config.useL2) step = std::min(step, config.l2.lineBytes);
+        for(uint32_t line = address & ~(step - 1); line < address + bytes; line += step) {
+            l1i.invalidate(line);
+            l1d.invalidate(line);
+            if(config.useL2) (bus != nullptr ? bus->l2 : l2).invalidate(line);
+        }
+    }
+
+    double instructionAmat() const {
+        return l1i.stats.accesses > 0 ? static_cast<double>(fetchCycles) / l1i.stats.accesses : 0.0;
+    }
+
+    double dataAmat() const {
+        return l1d.stats.accesses > 0 ? static_cast<double>(dataCycles) / l1d.stats.accesses : 0.0;
+    }
+
+    // On-chip SRAM the configuration costs, in bytes of data array
+    uint32_t sramBytes() const {
+        return config.l1i.sizeBytes + config.l1d.sizeBytes + (config.useL2 ? config.l2.sizeBytes : 0);
+    }
+};
+
+} // namespace isa
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef CLI_ARGS_H
+#define CLI_ARGS_H
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
+// Command-line number parsing shared by the workload simulators. Values are
+// checked rather than converted with std::sto*, whose exceptions would abort
+// the program on a typo; callers print their usage on false.
+namespace cli {
+
+// Parses a decimal count in [min, max]; false on anything else, including
+// signs, trailing text and overflow
+inline bool parseCount(const char* text, unsigned long min, unsigned long max, unsigned long& value) {
+    if(text[0] < '0' || text[0] > '9') return false;
+    char* end = nullptr;
+    errno = 0;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if(errno != 0 || *end != '\0' || parsed < min || parsed > max) return false;
+    value = parsed;
+    return true;
+}
+
+// A positive count that fits an int
+inline bool parseCount(const char* text, int& value) {
+    unsigned long parsed = 0;
+    if(!parseCount(text, 1, INT_MAX, parsed)) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+} // namespace cli
+
+#endif
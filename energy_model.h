@@ -0,0 +1,185 @@
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+
+// Energy accounting shared by the workload simulators. Simulator operations
+// charge counts to a per-thread ledger (one relaxed atomic add, no locks);
+// a snapshot sums the ledgers and converts counts to energy with the cost
+// table. Costs are per unit in nanojoules and default to ballpark figures
+// for a low-cost 28nm phone SoC; replace them with measured values via
+// setCost() when a calibration is available.
+namespace energy {
+
+enum Operation {
+    WIFI_SCAN = 0,      // one full-channel active Wi-Fi scan
+    BLE_SCAN_WINDOW,    // one 100ms BLE scan window
+    RADIO_ACTIVE_US,    // Wi-Fi/cellular radio on, per microsecond
+    CPU_CYCLE,          // one application-core cycle of modelled work
+    MAC_OP,             // one multiply-accumulate
+    SRAM_ACCESS,        // one 32-bit on-chip memory access
+    DRAM_ACCESS,        // one 32-bit off-chip memory access
+    FEATURE_FRAME,      // MFCC extraction for one 1024-sample frame
+    AUDIO_CAPTURE_MS,   // microphone + ADC on, per millisecond
+    SLEEP_LIGHT_US,     // clock-gated core, per microsecond
+    SLEEP_DEEP_US,      // power-gated core, retention only, per microsecond
+    OPERATION_COUNT
+};
+
+inline const char* operationName(int op) {
+    static const char* names[OPERATION_COUNT] = {
+        "Wi-Fi scan", "BLE scan window", "Radio active", "CPU cycle", "MAC",
+        "SRAM access", "DRAM access", "Feature frame", "Audio capture",
+        "Light sleep", "Deep sleep"
+    };
+    return names[op];
+}
+
+// Cost per unit in nanojoules
+inline double* costTable() {
+    static double costs[OPERATION_COUNT] = {
+        60000000.0,   // WIFI_SCAN: ~60mJ per active scan
+        1500000.0,    // BLE_SCAN_WINDOW: ~15mW for 100ms
+        250.0,        // RADIO_ACTIVE_US: ~250mW
+        0.25,         // CPU_CYCLE: ~50mW at 200MHz
+        0.005,        // MAC_OP: ~5pJ for an int8/int16 MAC
+        0.01,         // SRAM_ACCESS: ~10pJ
+        1.0,          // DRAM_ACCESS: ~1nJ for LPDDR
+        15000.0,      // FEATURE_FRAME: ~15uJ on a DSP
+        1000.0,       // AUDIO_CAPTURE_MS: ~1mW
+        5.0,          // SLEEP_LIGHT_US: ~5mW
+        0.05          // SLEEP_DEEP_US: ~50uW
+    };
+    return costs;
+}
+
+inline void setCost(Operation op, double nanojoules) {
+    costTable()[op] = nanojoules;
+}
+
+// Counts charged by one thread. Only the owning thread writes, so a relaxed
+// load/store pair is enough; readers may see slightly stale totals.
+struct Ledger {
+    std::atomic<uint64_t> counts[OPERATION_COUNT];
+
+    Ledger() {
+        for(auto& count : counts) count.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Ledgers outlive their threads so totals survive thread-pool shutdown
+inline std::mutex& registryMutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+inline std::vector<std::shared_ptr<Ledger>>& registry() {
+    static std::vector<std::shared_ptr<Ledger>> ledgers;
+    return ledgers;
+}
+
+inline Ledger& threadLedger() {
+    thread_local Ledger* ledger = nullptr;
+    if(ledger == nullptr) {
+        std::shared_ptr<Ledger> created = std::make_shared<Ledger>();
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(created);
+        ledger = created.get();
+    }
+    return *ledger;
+}
+
+inline void charge(Operation op, uint64_t units = 1) {
+    std::atomic<uint64_t>& count = threadLedger().counts[op];
+    count.store(count.load(std::memory_order_relaxed) + units, std::memory_order_relaxed);
+}
+
+// Summed counts across all threads at one point in time
+struct Snapshot {
+    uint64_t counts[OPERATION_COUNT];
+
+    double nanojoules(int op) const {
+        return counts[op] * costTable()[op];
+    }
+
+    double totalMilliJoules() const {
+        double total = 0.0;
+        for(int op = 0; op < OPERATION_COUNT; op++) total += nanojoules(op);
+        return total / 1e6;
+    }
+
+    Snapshot since(const Snapshot& earlier) const {
+        Snapshot delta;
+        for(int op = 0; op < OPERATION_COUNT; op++) delta.counts[op] = counts[op] - earlier.counts[op];
+        return delta;
+    }
+
+    // One line per operation that used energy, largest share first
+    std::string breakdown(uint64_t events) const {
+        std::vector<int> ops;
+        for(int op = 0; op < OPERATION_COUNT; op++) {
+            if(counts[op] > 0) ops.push_back(op);
+        }
+        std::sort(ops.begin(), ops.end(), [this](int a, int b) {
+            return nanojoules(a) > nanojoules(b);
+        });
+
+        std::string text;
+        double total = totalMilliJoules() * 1e6;
+        char line[128];
+        for(int op : ops) {
+            std::snprintf(line, sizeof(line), "   • %-15s %12.3f μJ/event (%4.1f%%)\n",
+                          operationName(op), nanojoules(op) / 1e3 / (events > 0 ? events : 1),
+                          total > 0.0 ? 100.0 * nanojoules(op) / total : 0.0);
+            text += line;
+        }
+        return text;
+    }
+};
+
+// Counts charged by the calling thread only; deltas of this are exact for
+// work done on one thread while other threads keep charging
+inline Snapshot threadSnapshot() {
+    Snapshot totals;
+    Ledger& ledger = threadLedger();
+    for(int op = 0; op < OPERATION_COUNT; op++) {
+        totals.counts[op] = ledger.counts[op].load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+// Core cycles implied by the work in a ledger delta: one per on-chip access
+// or MAC, plus a stall for each off-chip access. The CPU is charged from
+// these rather than from host time, so the figures are reproducible.
+const uint64_t DRAM_STALL_CYCLES = 20;
+
+inline uint64_t coreCycles(const Snapshot& work) {
+    return work.counts[SRAM_ACCESS] + work.counts[MAC_OP] + work.counts[DRAM_ACCESS] * DRAM_STALL_CYCLES;
+}
+
+inline void chargeCore(const Snapshot& work) {
+    charge(CPU_CYCLE, coreCycles(work));
+}
+
+inline Snapshot snapshot() {
+    Snapshot totals;
+    for(auto& count : totals.counts) count = 0;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for(const auto& ledger : registry()) {
+        for(int op = 0; op < OPERATION_COUNT; op++) {
+            totals.counts[op] += ledger->counts[op].load(std::memory_order_relaxed);
+        }
+    }
+    return totals;
+}
+
+} // namespace energy
+
+#endif
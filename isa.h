@@ -0,0 +1,375 @@
+#ifndef ISA_H
+#define ISA_H
+
+#include <string>
+#include <cstdint>
+#include <cstdio>
+
+// Encoding of the custom 16-bit ISA (Domain ISA Specification). Every
+// instruction is one halfword with a 4-bit opcode in bits [15:12]:
+//
+//   R-type  [ opcode | rd  | rs1 | rs2  ]   ADD SUB AND OR MAC VCMPEQ.B
+//   I-type  [ opcode | rd  | rs1 | imm4 ]   ADDI MULI XORI LW SW LHB
+//   B-type  [ opcode | rs1 | rs2 | imm4 ]   BEQ BNE BLT
+//   J-type  [ opcode | rd  |   imm8     ]   JAL
+//
+// Immediates are sign-extended. LW/SW scale imm4 by 4 and LHB uses it as a
+// byte offset; SW carries its source register in the rd field. Branch and
+// JAL offsets count instructions from pc+2.
+//
+// The spec lists 18 mnemonics for 16 opcodes, so the three without an
+// opcode of their own reuse encodings that had no architectural effect:
+//
+//   BCNT rd, rs1   = MULI rd, rs1, 0      (multiply by zero)
+//   system ops     = XORI x0, fn, arg     (write to the zero register)
+//     fn 0  NOP
+//     fn 1  SLEEPM arg    mode 15 powers the core off (ends simulation)
+//     fn 2  JR arg        jump to the address in register arg
+//     fn 3  MACMODE arg   what MAC computes from here on (experimental):
+//                         0 word MAC, 1 DOT4.B, 2 DOT2.H
+//     fn 8-15  LOOP arg   hardware loop (experimental): the next fn - 7
+//                         instructions run x[arg] times; x[arg] = 0 skips them
+//
+// A LOOP body ends at a fixed address; whenever execution reaches it with
+// iterations left it goes back to the top of the body, so the loop costs
+// no counter update or branch. There is one set of loop registers: a
+// LOOP inside a body replaces the active loop, and the body may only be
+// left by running off its end (a call that returns is fine).
+//
+// DOT4.B rd, rs1, rs2 adds the four int8 products of rs1 and rs2 into rd
+// and DOT2.H the two int16 products. Every opcode is taken, so they are
+// MAC under MACMODE 1 and 2 rather than encodings of their own.
+//
+// The packed-SIMD extension takes the R-type encodings that write x0, on
+// VECTOR_REGS registers v0-v7 of Machine::vectorBytes (4-32) bytes each
+// and a lane-wise 32-bit accumulator:
+//
+//   VLD v, (xN)+   = ADD x0, v, xN        load vectorBytes, xN += vectorBytes (xN != x0)
+//   VCMPEQ v, w    = SUB x0, v, w         byte lanes of v: equal to w -> 0xFF, else 0x00
+//   VXOR v, w      = AND x0, v, w         v ^= w
+//   VPOPC xN, v    = OR x0, xN, v         xN += number of set bits in v
+//   VMAC v, w      = MAC x0, v, w         acc[i] += v[i] * w[i] on 32-bit lanes
+//   VREDSUM xN     = VCMPEQ.B x0, xN, 0   xN = sum of acc lanes, acc = 0
+//   VLENB xN       = VCMPEQ.B x0, xN, 1   xN = vectorBytes
+//
+// Decoded vector operands are numbered VREG_BASE + v so hazard checks can
+// tell them from x registers.
+namespace isa {
+
+enum Opcode {
+    OP_ADD = 0, OP_SUB, OP_AND, OP_OR, OP_MAC, OP_VCMPEQB,
+    OP_ADDI, OP_MULI, OP_XORI, OP_LW, OP_SW, OP_LHB,
+    OP_JAL, OP_BEQ, OP_BNE, OP_BLT
+};
+
+enum SysFunction {
+    SYS_NOP = 0, SYS_SLEEPM, SYS_JR, SYS_MACMODE, SYS_LOOP = 8
+};
+
+enum MacMode {
+    MAC_WORD = 0, MAC_DOT4B, MAC_DOT2H
+};
+
+const int REG_COUNT = 16;
+const int REG_SP = 14;
+const int REG_LR = 15;
+const int SLEEP_POWER_OFF = 15;
+const int VECTOR_REGS = 8;
+const int VREG_BASE = 16;
+const int MAX_VECTOR_BYTES = 32;
+const int MAX_LOOP_BODY = 8;    // instructions, also the loop buffer size
+
+// Operation after decode, with the shared encodings split apart. Simulators
+// dispatch on this rather than on the raw opcode.
+enum Kind {
+    K_ADD = 0, K_SUB, K_AND, K_OR, K_MAC, K_VCMPEQB,
+    K_ADDI, K_MULI, K_BCNT, K_XORI, K_LW, K_SW, K_LHB,
+    K_JAL, K_BEQ, K_BNE, K_BLT,
+    K_NOP, K_SLEEPM, K_HALT, K_JR, K_MACMODE, K_LOOP, K_ILLEGAL,
+    K_VLD, K_VCMPEQ, K_VXOR, K_VPOPC, K_VMAC, K_VREDSUM, K_VLENB,
+    K_DECODE,   // decoded-instruction cache slot not filled yet
+    K_COUNT
+};
+
+// Decoded form: rs1/rs2 are always the registers read and rd the register
+// written (0 if none), whatever field the encoding keeps them in
+struct Instruction {
+    uint8_t kind;
+    uint8_t rd;
+    uint8_t rs1;
+    uint8_t rs2;
+    int32_t imm;
+};
+
+inline int32_t signExtend(uint32_t value, int bits) {
+    uint32_t sign = 1u << (bits - 1);
+    value &= (1u << bits) - 1;
+    return static_cast<int32_t>((value ^ sign) - sign);
+}
+
+// R-type writes to x0: the SIMD extension, or plain no-ops where it has
+// no encoding (ADD x0, v, x0 keeps 0x0000 a no-op)
+inline void decodeVector(Instruction& in, int op, int b, int c) {
+    int v = VREG_BASE + (b & 7);
+    int w = VREG_BASE + (c & 7);
+    in.imm = 0;
+    switch(op) {
+        case OP_ADD:
+            if(c == 0) return;
+            in.kind = K_VLD;
+            in.rd = static_cast<uint8_t>(v);
+            in.rs1 = static_cast<uint8_t>(c);
+            in.rs2 = 0;
+            break;
+        case OP_SUB: case OP_AND:
+            in.kind = op == OP_SUB ? K_VCMPEQ : K_VXOR;
+            in.rd = in.rs1 = static_cast<uint8_t>(v);
+            in.rs2 = static_cast<uint8_t>(w);
+            break;
+        case OP_OR:
+            in.kind = K_VPOPC;
+            in.rd = in.rs2 = static_cast<uint8_t>(b);
+            in.rs1 = static_cast<uint8_t>(w);
+            break;
+        case OP_MAC:
+            in.kind = K_VMAC;
+            in.rd = 0;
+            in.rs1 = static_cast<uint8_t>(v);
+            in.rs2 = static_cast<uint8_t>(w);
+            break;
+        default: // VCMPEQ.B x0: reductions and queries
+            in.kind = c == 0 ? K_VREDSUM : c == 1 ? K_VLENB : K_ILLEGAL;
+            in.rd = static_cast<uint8_t>(b);
+            in.rs1 = in.rs2 = 0;
+            break;
+    }
+}
+
+inline Instruction decode(uint16_t word) {
+    Instruction in;
+    int op = word >> 12;
+    int a = (word >> 8) & 0xF;
+    int b = (word >> 4) & 0xF;
+    int c = word & 0xF;
+    in.rd = static_cast<uint8_t>(a);
+    in.rs1 = static_cast<uint8_t>(b);
+    in.rs2 = static_cast<uint8_t>(c);
+    in.imm = signExtend(c, 4);
+
+    switch(op) {
+        case OP_ADD:     in.kind = K_ADD; in.imm = 0; break;
+        case OP_SUB:     in.kind = K_SUB; in.imm = 0; break;
+        case OP_AND:     in.kind = K_AND; in.imm = 0; break;
+        case OP_OR:      in.kind = K_OR; in.imm = 0; break;
+        case OP_MAC:     in.kind = K_MAC; in.imm = 0; break;
+        case OP_VCMPEQB: in.kind = K_VCMPEQB; in.imm = 0; break;
+        case OP_ADDI:    in.kind = K_ADDI; in.rs2 = 0; break;
+        case OP_MULI:    in.kind = c == 0 ? K_BCNT : K_MULI; in.rs2 = 0; break;
+        case OP_LW:      in.kind = K_LW; in.rs2 = 0; in.imm *= 4; break;
+        case OP_LHB:     in.kind = K_LHB; in.rs2 = 0; break;
+        case OP_SW:
+            in.kind = K_SW;
+            in.rs2 = static_cast<uint8_t>(a);
+            in.rd = 0;
+            in.imm *= 4;
+            break;
+        case OP_XORI:
+            in.kind = K_XORI;
+            in.rs2 = 0;
+            if(a == 0) {
+                in.rs1 = 0;
+                in.imm = c;
+                if(b == SYS_NOP) {
+                    in.kind = K_NOP;
+                } else if(b == SYS_SLEEPM) {
+                    in.kind = c == SLEEP_POWER_OFF ? K_HALT : K_SLEEPM;
+                } else if(b == SYS_JR) {
+                    in.kind = K_JR;
+                    in.rs1 = static_cast<uint8_t>(c);
+                    in.imm = 0;
+                } else if(b == SYS_MACMODE && c <= MAC_DOT2H) {
+                    in.kind = K_MACMODE;
+                } else if(b >= SYS_LOOP) {
+                    // imm is the body length in bytes, like a branch offset
+                    in.kind = K_LOOP;
+                    in.rs1 = static_cast<uint8_t>(c);
+                    in.imm = 2 * (b - SYS_LOOP + 1);
+                } else {
+                    in.kind = K_ILLEGAL;
+                }
+            }
+            break;
+        case OP_JAL:
+            in.kind = K_JAL;
+            in.rs1 = in.rs2 = 0;
+            in.imm = signExtend(word & 0xFF, 8) * 2;
+            break;
+        default: // BEQ, BNE, BLT
+            in.kind = op == OP_BEQ ? K_BEQ : op == OP_BNE ? K_BNE : K_BLT;
+            in.rs1 = static_cast<uint8_t>(a);
+            in.rs2 = static_cast<uint8_t>(b);
+            in.rd = 0;
+            in.imm *= 2;
+            break;
+    }
+    if(a == 0 && op <= OP_VCMPEQB) decodeVector(in, op, b, c);
+    return in;
+}
+
+inline bool isLoad(int kind) {
+    return kind == K_LW || kind == K_LHB || kind == K_VLD;
+}
+
+inline bool isMemoryAccess(int kind) {
+    return kind == K_LW || kind == K_LHB || kind == K_SW || kind == K_VLD;
+}
+
+inline bool isVector(int kind) {
+    return kind >= K_VLD && kind <= K_VLENB;
+}
+
+inline bool isControlTransfer(int kind) {
+    return kind == K_JAL || kind == K_JR || kind == K_BEQ || kind == K_BNE || kind == K_BLT;
+}
+
+inline bool isConditionalBranch(int kind) {
+    return kind == K_BEQ || kind == K_BNE || kind == K_BLT;
+}
+
+// True if the instruction reads reg; MAC also reads its accumulator
+inline bool readsRegister(const Instruction& in, int reg) {
+    return reg != 0 && (in.rs1 == reg || in.rs2 == reg || (in.kind == K_MAC && in.rd == reg));
+}
+
+// x-register file read and write ports the instruction uses (vector
+// registers and x0 need none)
+inline int registerReads(const Instruction& in) {
+    int reads = 0;
+    if(in.rs1 != 0 && in.rs1 < REG_COUNT) reads++;
+    if(in.rs2 != 0 && in.rs2 < REG_COUNT && in.rs2 != in.rs1) reads++;
+    if(in.kind == K_MAC && in.rd != 0 && in.rd != in.rs1 && in.rd != in.rs2) reads++;
+    return reads;
+}
+
+inline int registerWrites(const Instruction& in) {
+    return (in.rd != 0 && in.rd < REG_COUNT) || in.kind == K_VLD ? 1 : 0;
+}
+
+inline uint16_t encodeR(int op, int rd, int rs1, int rs2) {
+    return static_cast<uint16_t>((op << 12) | ((rd & 0xF) << 8) | ((rs1 & 0xF) << 4) | (rs2 & 0xF));
+}
+
+// Also used for B-type (rs1, rs2, offset) and SW (source, base, offset)
+inline uint16_t encodeI(int op, int rd, int rs1, int imm) {
+    return encodeR(op, rd, rs1, imm & 0xF);
+}
+
+inline uint16_t encodeJ(int rd, int offset) {
+    return static_cast<uint16_t>((OP_JAL << 12) | ((rd & 0xF) << 8) | (offset & 0xFF));
+}
+
+inline uint16_t encodeSys(int function, int arg) {
+    return encodeR(OP_XORI, 0, function, arg);
+}
+
+// Byte lanes equal -> 0xFF, else 0x00
+inline uint32_t vectorCompareBytes(uint32_t a, uint32_t b) {
+    uint32_t mask = 0;
+    for(int lane = 0; lane < 4; lane++) {
+        if(((a >> (8 * lane)) & 0xFF) == ((b >> (8 * lane)) & 0xFF)) mask |= 0xFFu << (8 * lane);
+    }
+    return mask;
+}
+
+// Sum of the signed byte (DOT4.B) or halfword (DOT2.H) lane products
+inline uint32_t dotBytes(uint32_t a, uint32_t b) {
+    int32_t sum = 0;
+    for(int lane = 0; lane < 4; lane++) {
+        sum += static_cast<int8_t>(a >> (8 * lane)) * static_cast<int8_t>(b >> (8 * lane));
+    }
+    return static_cast<uint32_t>(sum);
+}
+
+inline uint32_t dotHalves(uint32_t a, uint32_t b) {
+    int32_t sum = static_cast<int16_t>(a) * static_cast<int16_t>(b);
+    sum += static_cast<int16_t>(a >> 16) * static_cast<int16_t>(b >> 16);
+    return static_cast<uint32_t>(sum);
+}
+
+inline uint32_t bitCount(uint32_t value) {
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_popcount(value));
+#else
+    uint32_t count = 0;
+    for(; value != 0; value &= value - 1) count++;
+    return count;
+#endif
+}
+
+inline const char* kindName(int kind) {
+    static const char* names[K_COUNT] = {
+        "ADD", "SUB", "AND", "OR", "MAC", "VCMPEQ.B",
+        "ADDI", "MULI", "BCNT", "XORI", "LW", "SW", "LHB",
+        "JAL", "BEQ", "BNE", "BLT",
+        "NOP", "SLEEPM", "SLEEPM", "JR", "MACMODE", "LOOP", "ILLEGAL",
+        "VLD", "VCMPEQ", "VXOR", "VPOPC", "VMAC", "VREDSUM", "VLENB", "DECODE"
+    };
+    return names[kind];
+}
+
+inline std::string disassemble(uint16_t word, uint32_t pc) {
+    Instruction in = decode(word);
+    const char* name = kindName(in.kind);
+    char text[48];
+    switch(in.kind) {
+        case K_ADD: case K_SUB: case K_AND: case K_OR: case K_MAC: case K_VCMPEQB:
+            std::snprintf(text, sizeof(text), "%-8s x%d, x%d, x%d", name, in.rd, in.rs1, in.rs2);
+            break;
+        case K_ADDI: case K_MULI: case K_XORI:
+            std::snprintf(text, sizeof(text), "%-8s x%d, x%d, %d", name, in.rd, in.rs1, in.imm);
+            break;
+        case K_BCNT:
+            std::snprintf(text, sizeof(text), "%-8s x%d, x%d", name, in.rd, in.rs1);
+            break;
+        case K_LW: case K_LHB:
+            std::snprintf(text, sizeof(text), "%-8s x%d, %d(x%d)", name, in.rd, in.imm, in.rs1);
+            break;
+        case K_SW:
+            std::snprintf(text, sizeof(text), "%-8s x%d, %d(x%d)", name, in.rs2, in.imm, in.rs1);
+            break;
+        case K_JAL:
+            std::snprintf(text, sizeof(text), "%-8s x%d, 0x%04x", name, in.rd, pc + 2 + in.imm);
+            break;
+        case K_BEQ: case K_BNE: case K_BLT:
+            std::snprintf(text, sizeof(text), "%-8s x%d, x%d, 0x%04x", name, in.rs1, in.rs2, pc + 2 + in.imm);
+            break;
+        case K_SLEEPM: case K_HALT: case K_MACMODE:
+            std::snprintf(text, sizeof(text), "%-8s %d", name, in.imm);
+            break;
+        case K_JR:
+            std::snprintf(text, sizeof(text), "%-8s x%d", name, in.rs1);
+            break;
+        case K_LOOP:
+            std::snprintf(text, sizeof(text), "%-8s x%d, 0x%04x", name, in.rs1, pc + 2 + in.imm);
+            break;
+        case K_VLD:
+            std::snprintf(text, sizeof(text), "%-8s v%d, (x%d)+", name, in.rd - VREG_BASE, in.rs1);
+            break;
+        case K_VCMPEQ: case K_VXOR: case K_VMAC:
+            std::snprintf(text, sizeof(text), "%-8s v%d, v%d", name, in.rs1 - VREG_BASE, in.rs2 - VREG_BASE);
+            break;
+        case K_VPOPC:
+            std::snprintf(text, sizeof(text), "%-8s x%d, v%d", name, in.rd, in.rs1 - VREG_BASE);
+            break;
+        case K_VREDSUM: case K_VLENB:
+            std::snprintf(text, sizeof(text), "%-8s x%d", name, in.rd);
+            break;
+        default:
+            std::snprintf(text, sizeof(text), "%s", name);
+    }
+    return text;
+}
+
+} // namespace isa
+
+#endif
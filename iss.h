@@ -0,0 +1,436 @@
+#ifndef ISS_H
+#define ISS_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include "isa.h"
+
+// Functional instruction-set simulator for the 16-bit ISA. Each halfword of
+// memory has a slot in a decoded-instruction cache that is filled the first
+// time it executes; stores invalidate the slots they overwrite, so
+// self-modifying code stays correct. Dispatch is threaded (computed goto)
+// on GCC/Clang, with a switch loop elsewhere.
+//
+// codeMap marks every halfword that is held decoded here or translated by
+// a JIT, so a store only pays for invalidation when it hits code, and a
+// store to marked code sets codeModified for the translator to notice.
+//
+// vectorBytes sets the width of the packed-SIMD extension (4, 8, 16 or 32).
+//
+// The hardware loop is checked between instructions: when pc reaches
+// loopEnd, loopCount drops and pc goes back to loopStart until it runs out.
+//
+// SLEEPM normally wakes at once. With wakeOnInterrupt set it stops run()
+// with status SLEEPING, pc past the SLEEPM, until interrupt() is called; an
+// interrupt that arrives while the core is awake is latched, so the next
+// SLEEPM falls straight through.
+//
+// For sampled simulation (simpoint.h), blockCounts turns on basic-block
+// profiling: every control transfer, and the end of a hardware loop body,
+// adds the instructions retired since the previous one to the count of the
+// block it ends, indexed by that instruction's pc / 2. save() and restore()
+// checkpoint the architectural state.
+namespace isa {
+
+class Machine {
+public:
+    enum Status { RUNNING, HALTED, FAULT, STEP_LIMIT, SLEEPING };
+
+    static const uint32_t MEMORY_BYTES = 64 * 1024;
+    static const uint32_t NO_LOOP = 0xFFFFFFFF;
+
+    uint32_t regs[REG_COUNT];
+    uint32_t pc;
+    std::vector<uint8_t> memory;
+    Status status;
+    std::string fault;
+
+    uint64_t instret;
+    uint64_t kindCounts[K_COUNT];
+    uint64_t sleepRequests;     // SLEEPM other than power-off
+    int lastSleepMode;
+    bool wakeOnInterrupt;       // SLEEPM waits for interrupt()
+    bool wakeEvent;             // an interrupt arrived since the last SLEEPM
+    int macMode;                // MacMode selected by MACMODE
+    uint32_t loopStart;         // hardware loop registers set by LOOP
+    uint32_t loopEnd;           // NO_LOOP when no loop is active
+    uint32_t loopCount;         // iterations left, including the current one
+
+    std::vector<uint8_t> codeMap;   // one byte per halfword, plus a spare
+    bool codeModified;
+
+    uint32_t vectorBytes;
+    uint8_t vregs[VECTOR_REGS][MAX_VECTOR_BYTES];
+    int32_t vacc[MAX_VECTOR_BYTES / 4];
+
+    std::vector<uint64_t>* blockCounts;     // MEMORY_BYTES / 2 entries, or nullptr
+    uint64_t blockStart;                    // instret when the current block began
+
+    // Architectural state: what a program can observe, without statistics
+    // or the decoded-instruction cache
+    struct Checkpoint {
+        uint32_t regs[REG_COUNT];
+        uint32_t pc;
+        std::vector<uint8_t> memory;
+        int macMode;
+        uint32_t loopStart;
+        uint32_t loopEnd;
+        uint32_t loopCount;
+        uint32_t vectorBytes;
+        uint8_t vregs[VECTOR_REGS][MAX_VECTOR_BYTES];
+        int32_t vacc[MAX_VECTOR_BYTES / 4];
+        uint64_t instret;           // where in the run it was taken
+    };
+
+private:
+    // One slot per halfword plus a sentinel that faults when execution
+    // runs off the end of memory
+    std::vector<Instruction> decoded;
+
+    // pc reached the end of the loop body
+    void endOfLoopBody(uint64_t executed) {
+        if(blockCounts != nullptr) endBlock(pc - 2, executed);
+        if(--loopCount == 0) loopEnd = NO_LOOP;
+        else pc = loopStart;
+    }
+
+    void endBlock(uint32_t at, uint64_t executed) {
+        uint64_t now = instret + executed;
+        (*blockCounts)[at >> 1] += now - blockStart;
+        blockStart = now;
+    }
+
+    void invalidate(uint32_t address, uint32_t bytes) {
+        for(uint32_t slot = address >> 1; slot <= (address + bytes - 1) >> 1; slot++) {
+            decoded[slot].kind = K_DECODE;
+            if(codeMap[slot]) {
+                codeMap[slot] = 0;
+                codeModified = true;
+            }
+        }
+    }
+
+public:
+    Machine() : memory(MEMORY_BYTES, 0), codeMap(MEMORY_BYTES / 2 + 1, 0), codeModified(false), vectorBytes(16),
+                decoded(MEMORY_BYTES / 2 + 1) {
+        for(auto& slot : decoded) slot.kind = K_DECODE;
+        decoded.back().kind = K_ILLEGAL;
+        wakeOnInterrupt = false;
+        blockCounts = nullptr;
+        reset();
+    }
+
+    // Clears registers and statistics; memory and decoded instructions are kept
+    void reset() {
+        std::memset(regs, 0, sizeof(regs));
+        std::memset(vregs, 0, sizeof(vregs));
+        std::memset(vacc, 0, sizeof(vacc));
+        regs[REG_SP] = MEMORY_BYTES - 4;
+        pc = 0;
+        status = RUNNING;
+        fault.clear();
+        instret = 0;
+        std::memset(kindCounts, 0, sizeof(kindCounts));
+        sleepRequests = 0;
+        lastSleepMode = 0;
+        wakeEvent = false;
+        macMode = MAC_WORD;
+        loopStart = loopCount = 0;
+        loopEnd = NO_LOOP;
+        blockStart = 0;
+    }
+
+    Checkpoint save() const {
+        Checkpoint state;
+        std::memcpy(state.regs, regs, sizeof(regs));
+        state.pc = pc;
+        state.memory = memory;
+        state.macMode = macMode;
+        state.loopStart = loopStart;
+        state.loopEnd = loopEnd;
+        state.loopCount = loopCount;
+        state.vectorBytes = vectorBytes;
+        std::memcpy(state.vregs, vregs, sizeof(vregs));
+        std::memcpy(state.vacc, vacc, sizeof(vacc));
+        state.instret = instret;
+        return state;
+    }
+
+    // Resumes from state with fresh statistics; instret continues from the
+    // checkpoint
+    void restore(const Checkpoint& state) {
+        reset();
+        std::memcpy(regs, state.regs, sizeof(regs));
+        pc = state.pc;
+        loadBytes(state.memory, 0);
+        macMode = state.macMode;
+        loopStart = state.loopStart;
+        loopEnd = state.loopEnd;
+        loopCount = state.loopCount;
+        vectorBytes = state.vectorBytes;
+        std::memcpy(vregs, state.vregs, sizeof(vregs));
+        std::memcpy(vacc, state.vacc, sizeof(vacc));
+        instret = blockStart = state.instret;
+    }
+
+    bool loopActive() const { return loopEnd != NO_LOOP; }
+
+    // An enabled interrupt line went active
+    void interrupt() {
+        if(status == SLEEPING) status = RUNNING;
+        else wakeEvent = true;
+    }
+
+    void loadProgram(const uint16_t* code, size_t count, uint32_t address) {
+        for(size_t i = 0; i < count; i++) writeHalf(address + 2 * i, code[i]);
+    }
+
+    void loadBytes(const std::vector<uint8_t>& bytes, uint32_t address) {
+        if(bytes.empty()) return;
+        std::memcpy(&memory[address], bytes.data(), bytes.size());
+        invalidate(address, static_cast<uint32_t>(bytes.size()));
+    }
+
+    uint16_t readHalf(uint32_t address) const {
+        return static_cast<uint16_t>(memory[address] | (memory[address + 1] << 8));
+    }
+
+    void writeHalf(uint32_t address, uint16_t value) {
+        memory[address] = static_cast<uint8_t>(value);
+        memory[address + 1] = static_cast<uint8_t>(value >> 8);
+        invalidate(address, 2);
+    }
+
+    uint32_t readWord(uint32_t address) const {
+        uint32_t value;
+        std::memcpy(&value, &memory[address], 4);   // host is little-endian like the target
+        return value;
+    }
+
+    void writeWord(uint32_t address, uint32_t value) {
+        std::memcpy(&memory[address], &value, 4);
+        invalidate(address, 4);
+    }
+
+    // Runs until power-off, a fault, or maxInstructions retire
+    Status run(uint64_t maxInstructions) {
+        if(status != RUNNING) return status;
+        uint64_t executed = 0;
+        const Instruction* in;
+        uint32_t address;
+        uint32_t sum;
+
+#if defined(__GNUC__)
+        static const void* handlers[K_COUNT] = {
+            &&op_K_ADD, &&op_K_SUB, &&op_K_AND, &&op_K_OR, &&op_K_MAC, &&op_K_VCMPEQB,
+            &&op_K_ADDI, &&op_K_MULI, &&op_K_BCNT, &&op_K_XORI, &&op_K_LW, &&op_K_SW, &&op_K_LHB,
+            &&op_K_JAL, &&op_K_BEQ, &&op_K_BNE, &&op_K_BLT,
+            &&op_K_NOP, &&op_K_SLEEPM, &&op_K_HALT, &&op_K_JR, &&op_K_MACMODE, &&op_K_LOOP, &&op_K_ILLEGAL,
+            &&op_K_VLD, &&op_K_VCMPEQ, &&op_K_VXOR, &&op_K_VPOPC, &&op_K_VMAC, &&op_K_VREDSUM, &&op_K_VLENB,
+            &&op_K_DECODE
+        };
+#define ISS_OP(kind) op_##kind:
+#define ISS_DISPATCH() do { \
+            if(executed == maxInstructions) goto stop_limit; \
+            in = &decoded[pc >> 1]; \
+            executed++; \
+            kindCounts[in->kind]++; \
+            goto *handlers[in->kind]; \
+        } while(0)
+#define ISS_NEXT() do { \
+            if(pc == loopEnd) endOfLoopBody(executed); \
+            ISS_DISPATCH(); \
+        } while(0)
+        ISS_DISPATCH();
+#else
+#define ISS_OP(kind) case kind:
+#define ISS_DISPATCH() continue
+#define ISS_NEXT() if(pc == loopEnd) endOfLoopBody(executed); continue
+        for(;;) {
+            if(executed == maxInstructions) goto stop_limit;
+            in = &decoded[pc >> 1];
+            executed++;
+            kindCounts[in->kind]++;
+            switch(in->kind) {
+#endif
+
+#define ISS_WRITE(value) do { regs[in->rd] = (value); regs[0] = 0; pc += 2; } while(0)
+#define ISS_BLOCK_END() do { \
+            if(blockCounts != nullptr) endBlock(pc, executed); \
+        } while(0)
+#define ISS_JUMP(target) do { \
+            address = (target); \
+            if(address >= MEMORY_BYTES || (address & 1)) { fault = "bad jump target"; goto stop_fault; } \
+            pc = address; \
+        } while(0)
+
+        ISS_OP(K_ADD) ISS_WRITE(regs[in->rs1] + regs[in->rs2]); ISS_NEXT();
+        ISS_OP(K_SUB) ISS_WRITE(regs[in->rs1] - regs[in->rs2]); ISS_NEXT();
+        ISS_OP(K_AND) ISS_WRITE(regs[in->rs1] & regs[in->rs2]); ISS_NEXT();
+        ISS_OP(K_OR) ISS_WRITE(regs[in->rs1] | regs[in->rs2]); ISS_NEXT();
+        ISS_OP(K_MAC)
+            if(macMode == MAC_WORD) ISS_WRITE(regs[in->rd] + regs[in->rs1] * regs[in->rs2]);
+            else if(macMode == MAC_DOT4B) ISS_WRITE(regs[in->rd] + dotBytes(regs[in->rs1], regs[in->rs2]));
+            else ISS_WRITE(regs[in->rd] + dotHalves(regs[in->rs1], regs[in->rs2]));
+            ISS_NEXT();
+        ISS_OP(K_VCMPEQB) ISS_WRITE(vectorCompareBytes(regs[in->rs1], regs[in->rs2])); ISS_NEXT();
+        ISS_OP(K_ADDI) ISS_WRITE(regs[in->rs1] + in->imm); ISS_NEXT();
+        ISS_OP(K_MULI) ISS_WRITE(regs[in->rs1] * static_cast<uint32_t>(in->imm)); ISS_NEXT();
+        ISS_OP(K_BCNT) ISS_WRITE(bitCount(regs[in->rs1])); ISS_NEXT();
+        ISS_OP(K_XORI) ISS_WRITE(regs[in->rs1] ^ static_cast<uint32_t>(in->imm)); ISS_NEXT();
+        ISS_OP(K_LW)
+            address = regs[in->rs1] + in->imm;
+            if((address & 3) || address > MEMORY_BYTES - 4) { fault = "bad load address"; goto stop_fault; }
+            ISS_WRITE(readWord(address));
+            ISS_NEXT();
+        ISS_OP(K_SW)
+            address = regs[in->rs1] + in->imm;
+            if((address & 3) || address > MEMORY_BYTES - 4) { fault = "bad store address"; goto stop_fault; }
+            std::memcpy(&memory[address], &regs[in->rs2], 4);
+            if(codeMap[address >> 1] | codeMap[(address >> 1) + 1]) invalidate(address, 4);
+            pc += 2;
+            ISS_NEXT();
+        ISS_OP(K_LHB)
+            address = regs[in->rs1] + in->imm;
+            if(address >= MEMORY_BYTES) { fault = "bad load address"; goto stop_fault; }
+            ISS_WRITE(static_cast<uint32_t>(static_cast<int8_t>(memory[address])));
+            ISS_NEXT();
+        ISS_OP(K_JAL)
+            ISS_BLOCK_END();
+            regs[in->rd] = pc + 2;
+            regs[0] = 0;
+            ISS_JUMP(pc + 2 + in->imm);
+            ISS_NEXT();
+        ISS_OP(K_BEQ)
+            ISS_BLOCK_END();
+            if(regs[in->rs1] == regs[in->rs2]) ISS_JUMP(pc + 2 + in->imm); else pc += 2;
+            ISS_NEXT();
+        ISS_OP(K_BNE)
+            ISS_BLOCK_END();
+            if(regs[in->rs1] != regs[in->rs2]) ISS_JUMP(pc + 2 + in->imm); else pc += 2;
+            ISS_NEXT();
+        ISS_OP(K_BLT)
+            ISS_BLOCK_END();
+            if(static_cast<int32_t>(regs[in->rs1]) < static_cast<int32_t>(regs[in->rs2])) {
+                ISS_JUMP(pc + 2 + in->imm);
+            } else {
+                pc += 2;
+            }
+            ISS_NEXT();
+        ISS_OP(K_NOP) pc += 2; ISS_NEXT();
+        ISS_OP(K_SLEEPM)
+            // Functional model: the core wakes immediately unless it waits
+            // for an interrupt that has not arrived yet
+            sleepRequests++;
+            lastSleepMode = in->imm;
+            pc += 2;
+            if(wakeOnInterrupt && !wakeEvent) {
+                instret += executed;
+                status = SLEEPING;
+                return status;
+            }
+            wakeEvent = false;
+            ISS_NEXT();
+        ISS_OP(K_HALT)
+            lastSleepMode = in->imm;
+            pc += 2;
+            instret += executed;
+            status = HALTED;
+            return status;
+        ISS_OP(K_JR) ISS_BLOCK_END(); ISS_JUMP(regs[in->rs1]); ISS_NEXT();
+        ISS_OP(K_MACMODE) macMode = in->imm; pc += 2; ISS_NEXT();
+        ISS_OP(K_LOOP)
+            ISS_BLOCK_END();
+            loopCount = regs[in->rs1];
+            if(loopCount == 0) {
+                loopEnd = NO_LOOP;
+                ISS_JUMP(pc + 2 + in->imm);
+            } else {
+                loopStart = pc + 2;
+                loopEnd = pc + 2 + in->imm;
+                pc = loopStart;
+            }
+            ISS_NEXT();
+        ISS_OP(K_ILLEGAL)
+            fault = pc >= MEMORY_BYTES ? "ran off the end of memory" : "illegal instruction";
+            goto stop_fault;
+        ISS_OP(K_VLD)
+            address = regs[in->rs1];
+            if((address & 3) || address > MEMORY_BYTES - vectorBytes) { fault = "bad vector load address"; goto stop_fault; }
+            std::memcpy(vregs[in->rd - VREG_BASE], &memory[address], vectorBytes);
+            regs[in->rs1] = address + vectorBytes;
+            pc += 2;
+            ISS_NEXT();
+        ISS_OP(K_VCMPEQ)
+            for(uint32_t i = 0; i < vectorBytes; i++) {
+                uint8_t& lane = vregs[in->rs1 - VREG_BASE][i];
+                lane = lane == vregs[in->rs2 - VREG_BASE][i] ? 0xFF : 0x00;
+            }
+            pc += 2;
+            ISS_NEXT();
+        ISS_OP(K_VXOR)
+            for(uint32_t i = 0; i < vectorBytes; i++) vregs[in->rs1 - VREG_BASE][i] ^= vregs[in->rs2 - VREG_BASE][i];
+            pc += 2;
+            ISS_NEXT();
+        ISS_OP(K_VPOPC)
+            sum = 0;
+            for(uint32_t i = 0; i < vectorBytes; i += 4) {
+                uint32_t lane;
+                std::memcpy(&lane, &vregs[in->rs1 - VREG_BASE][i], 4);
+                sum += bitCount(lane);
+            }
+            ISS_WRITE(regs[in->rs2] + sum);
+            ISS_NEXT();
+        ISS_OP(K_VMAC)
+            for(uint32_t i = 0; i < vectorBytes / 4; i++) {
+                int32_t a, b;
+                std::memcpy(&a, &vregs[in->rs1 - VREG_BASE][4 * i], 4);
+                std::memcpy(&b, &vregs[in->rs2 - VREG_BASE][4 * i], 4);
+                vacc[i] = static_cast<int32_t>(static_cast<uint32_t>(vacc[i]) + static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+            }
+            pc += 2;
+            ISS_NEXT();
+        ISS_OP(K_VREDSUM)
+            sum = 0;
+            for(uint32_t i = 0; i < vectorBytes / 4; i++) sum += static_cast<uint32_t>(vacc[i]);
+            std::memset(vacc, 0, sizeof(vacc));
+            ISS_WRITE(sum);
+            ISS_NEXT();
+        ISS_OP(K_VLENB) ISS_WRITE(vectorBytes); ISS_NEXT();
+        ISS_OP(K_DECODE)
+            decoded[pc >> 1] = decode(readHalf(pc));
+            codeMap[pc >> 1] = 1;
+            executed--;
+            kindCounts[K_DECODE]--;
+            ISS_DISPATCH();
+
+#if !defined(__GNUC__)
+            default:
+                fault = "bad decoded slot";
+                goto stop_fault;
+            }
+        }
+#endif
+#undef ISS_OP
+#undef ISS_DISPATCH
+#undef ISS_NEXT
+#undef ISS_WRITE
+#undef ISS_JUMP
+#undef ISS_BLOCK_END
+
+    stop_limit:
+        instret += executed;
+        return STEP_LIMIT;
+    stop_fault:
+        instret += executed - 1;
+        kindCounts[in->kind]--;
+        status = FAULT;
+        return status;
+    }
+};
+
+} // namespace isa
+
+#endif
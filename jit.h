@@ -0,0 +1,498 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <initializer_list>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "isa.h"
+#include "iss.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__FreeBSD__))
+#define ISA_JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+// Dynamic binary translator from the 16-bit ISA to x86-64, used in place
+// of Machine::run. Guest code is translated one basic block at a time (up
+// to the first control transfer) into a 4MB executable buffer.
+//
+//  - Guest registers stay in Machine::regs, addressed off rbx; guest
+//    memory is off r12. MAC lowers to imul + add, BCNT to popcnt and
+//    VCMPEQ.B to pcmpeqb.
+//  - Blocks chain: a direct branch or jump is patched into a jmp to its
+//    target's code once that exists, and JR looks its target up in a
+//    per-halfword table, so control only returns to C++ for untranslated
+//    targets.
+//  - Each block subtracts its length from an instruction budget on entry
+//    and leaves if the budget is short; the interpreter runs the tail, so
+//    run(n) retires exactly what Machine::run(n) would.
+//  - SLEEPM, power-off, illegal encodings and any access that would fault
+//    exit to the interpreter, which executes that one instruction with its
+//    usual semantics and error messages.
+//  - Stores check Machine::codeMap; a store that lands on translated (or
+//    decoded) code leaves the block, and the whole translation cache is
+//    dropped before running on.
+//  - Blocks know nothing of the hardware loop, so while a LOOP is active
+//    (LOOP itself is interpreted) the interpreter runs the body.
+//
+// Other hosts keep the class but run() just calls the interpreter.
+namespace isa {
+
+class Jit {
+public:
+    static const int MAX_BLOCK_INSTRUCTIONS = 64;
+    static const int MAX_BLOCKS = 8192;
+    static const size_t CODE_BYTES = 4 << 20;
+
+    uint64_t blocksTranslated;
+    uint64_t chainsPatched;
+    uint64_t cacheFlushes;
+    uint64_t interpreterExits;      // instructions handed to the interpreter
+
+private:
+    enum Exit { EXIT_DISPATCH = 0, EXIT_BUDGET, EXIT_INTERPRET, EXIT_STORE_TO_CODE };
+
+    // Shared with generated code through r13; the offsets are hard-coded
+    // in the emitters below
+    struct Context {
+        uint64_t budget;        // 0
+        uint32_t pc;            // 8: next guest pc on exit
+        uint32_t reason;        // 12
+        uint32_t block;         // 16: block that took a side exit
+        uint32_t address;       // 20: store address for EXIT_STORE_TO_CODE
+        uint8_t* codeMap;       // 24
+        uint64_t blockRuns[MAX_BLOCKS];
+    };
+    static_assert(offsetof(Context, pc) == 8 && offsetof(Context, reason) == 12 && offsetof(Context, block) == 16 &&
+                  offsetof(Context, address) == 20 && offsetof(Context, codeMap) == 24,
+                  "generated code hard-codes the Context layout");
+
+    struct Block {
+        uint32_t pc;
+        std::vector<uint8_t> kinds;
+    };
+
+    // A rel32 operand in the block being emitted and where it should go
+    struct ExitStub {
+        size_t site;
+        uint32_t pc;
+        uint32_t reason;
+        bool dynamicPc;         // JR miss: pc is in eax
+        bool storeAddress;      // store to code: address is in eax
+    };
+
+    struct ChainExit {
+        size_t site;
+        uint32_t target;
+    };
+
+    typedef void (*EntryFunction)(uint32_t* regs, uint8_t* memory, Context* context, void** table, const void* block);
+
+    Machine& machine;
+    std::unique_ptr<Context> context;
+    std::vector<void*> table;                           // guest pc / 2 -> translated block
+    std::vector<Block> blocks;
+    std::multimap<uint32_t, size_t> pendingChains;      // target pc -> jump operand still aimed at a stub
+    uint8_t* code;
+    size_t codeUsed;
+    size_t firstBlockOffset;
+    size_t exitOffset;
+    bool hasPopcnt;
+    int translatedMacMode;      // blocks compile MAC for this mode only
+
+    Jit(const Jit&);
+    Jit& operator=(const Jit&);
+
+    void emit8(uint8_t value) { code[codeUsed++] = value; }
+
+    void emit(std::initializer_list<uint8_t> bytes) {
+        for(uint8_t value : bytes) emit8(value);
+    }
+
+    void emit32(uint32_t value) {
+        std::memcpy(code + codeUsed, &value, 4);
+        codeUsed += 4;
+    }
+
+    // Emits opcode plus a rel32 to be bound later; returns the rel32 offset
+    size_t emitJump(std::initializer_list<uint8_t> opcode) {
+        emit(opcode);
+        size_t site = codeUsed;
+        emit32(0);
+        return site;
+    }
+
+    void bind(size_t site, size_t target) {
+        int32_t relative = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(site + 4));
+        std::memcpy(code + site, &relative, 4);
+    }
+
+    static uint8_t slot(int reg) { return static_cast<uint8_t>(4 * reg); }
+
+    void loadEax(int reg) { emit({0x8B, 0x43, slot(reg)}); }                 // mov eax, [rbx+4*reg]
+
+    void storeEax(int reg) {
+        if(reg != 0) emit({0x89, 0x43, slot(reg)});                          // mov [rbx+4*reg], eax
+    }
+
+    void storeContext(uint8_t offset, uint32_t value) {
+        emit({0x41, 0xC7, 0x45, offset});                                   // mov dword [r13+offset], imm32
+        emit32(value);
+    }
+
+    void emitEntryAndExit() {
+        // entry(regs, memory, context, table, block): save callee-saved
+        // registers, load the fixed ones and jump into the block
+        emit({0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57}); // push rbx rbp r12-r15
+        emit({0x48, 0x89, 0xFB});                                           // mov rbx, rdi
+        emit({0x49, 0x89, 0xF4});                                           // mov r12, rsi
+        emit({0x49, 0x89, 0xD5});                                           // mov r13, rdx
+        emit({0x49, 0x89, 0xCE});                                           // mov r14, rcx
+        emit({0x4D, 0x8B, 0x7D, 0x00});                                     // mov r15, [r13] (budget)
+        emit({0x41, 0xFF, 0xE0});                                           // jmp r8
+        exitOffset = codeUsed;
+        emit({0x4D, 0x89, 0x7D, 0x00});                                     // mov [r13], r15
+        emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B}); // pop r15-r12 rbp rbx
+        emit8(0xC3);                                                        // ret
+        firstBlockOffset = codeUsed;
+    }
+
+    bool translatable(const Instruction& in, uint32_t pc) const {
+        switch(in.kind) {
+            case K_SLEEPM: case K_HALT: case K_MACMODE: case K_LOOP: case K_ILLEGAL: case K_DECODE:
+                return false;
+            case K_MAC:
+                return machine.macMode == MAC_WORD;   // DOT4.B/DOT2.H are interpreted
+            case K_VLD: case K_VCMPEQ: case K_VXOR: case K_VPOPC: case K_VMAC: case K_VREDSUM: case K_VLENB:
+                return false;   // the SIMD extension runs in the interpreter
+            case K_BCNT:
+                return hasPopcnt;
+            case K_JAL: case K_BEQ: case K_BNE: case K_BLT:
+                return pc + 2 + in.imm < Machine::MEMORY_BYTES;
+            default:
+                return true;
+        }
+    }
+
+    void emitFaultChecks(uint32_t pc, uint32_t alignMask, uint32_t lastAddress, std::vector<ExitStub>& stubs) {
+        if(alignMask != 0) {
+            emit({0xA8, static_cast<uint8_t>(alignMask)});                  // test al, mask
+            stubs.push_back({emitJump({0x0F, 0x85}), pc, EXIT_INTERPRET, false, false});  // jnz
+        }
+        emit8(0x3D);                                                        // cmp eax, lastAddress
+        emit32(lastAddress);
+        stubs.push_back({emitJump({0x0F, 0x87}), pc, EXIT_INTERPRET, false, false});      // ja
+    }
+
+    void emitInstruction(const Instruction& in, uint32_t pc, std::vector<ExitStub>& stubs,
+                         std::vector<ChainExit>& chains) {
+        uint8_t imm8 = static_cast<uint8_t>(in.imm);
+        switch(in.kind) {
+            case K_ADD: case K_SUB: case K_AND: case K_OR: {
+                if(in.rd == 0) break;
+                static const uint8_t opcodes[] = {0x03, 0x2B, 0x23, 0x0B};         // add sub and or eax, [rbx+d8]
+                loadEax(in.rs1);
+                emit({opcodes[in.kind - K_ADD], 0x43, slot(in.rs2)});
+                storeEax(in.rd);
+                break;
+            }
+            case K_MAC:
+                if(in.rd == 0) break;
+                loadEax(in.rs1);
+                emit({0x0F, 0xAF, 0x43, slot(in.rs2)});                     // imul eax, [rs2]
+                emit({0x01, 0x43, slot(in.rd)});                            // add [rd], eax
+                break;
+            case K_VCMPEQB:
+                if(in.rd == 0) break;
+                emit({0x66, 0x0F, 0x6E, 0x43, slot(in.rs1)});               // movd xmm0, [rs1]
+                emit({0x66, 0x0F, 0x6E, 0x4B, slot(in.rs2)});               // movd xmm1, [rs2]
+                emit({0x66, 0x0F, 0x74, 0xC1});                             // pcmpeqb xmm0, xmm1
+                emit({0x66, 0x0F, 0x7E, 0x43, slot(in.rd)});                // movd [rd], xmm0
+                break;
+            case K_ADDI:
+                if(in.rd == 0) break;
+                if(in.rs1 == 0) {
+                    emit({0xC7, 0x43, slot(in.rd)});                        // mov dword [rd], imm32
+                    emit32(static_cast<uint32_t>(in.imm));
+                    break;
+                }
+                loadEax(in.rs1);
+                emit({0x83, 0xC0, imm8});                                   // add eax, imm8
+                storeEax(in.rd);
+                break;
+            case K_MULI:
+                if(in.rd == 0) break;
+                emit({0x6B, 0x43, slot(in.rs1), imm8});                     // imul eax, [rs1], imm8
+                storeEax(in.rd);
+                break;
+            case K_BCNT:
+                if(in.rd == 0) break;
+                emit({0xF3, 0x0F, 0xB8, 0x43, slot(in.rs1)});               // popcnt eax, [rs1]
+                storeEax(in.rd);
+                break;
+            case K_XORI:
+                loadEax(in.rs1);
+                emit({0x83, 0xF0, imm8});                                   // xor eax, imm8
+                storeEax(in.rd);
+                break;
+            case K_NOP:
+                break;
+            case K_LW: case K_LHB: case K_SW:
+                loadEax(in.rs1);
+                if(in.imm != 0) emit({0x83, 0xC0, imm8});
+                if(in.kind == K_LHB) {
+                    emitFaultChecks(pc, 0, Machine::MEMORY_BYTES - 1, stubs);
+                    emit({0x41, 0x0F, 0xBE, 0x04, 0x04});                   // movsx eax, byte [r12+rax]
+                    storeEax(in.rd);
+                    break;
+                }
+                emitFaultChecks(pc, 3, Machine::MEMORY_BYTES - 4, stubs);
+                if(in.kind == K_LW) {
+                    emit({0x41, 0x8B, 0x04, 0x04});                         // mov eax, [r12+rax]
+                    storeEax(in.rd);
+                    break;
+                }
+                emit({0x8B, 0x4B, slot(in.rs2)});                           // mov ecx, [rs2]
+                emit({0x41, 0x89, 0x0C, 0x04});                             // mov [r12+rax], ecx
+                emit({0x89, 0xC1, 0xD1, 0xE9});                             // mov ecx, eax; shr ecx, 1
+                emit({0x49, 0x8B, 0x55, 0x18});                             // mov rdx, [r13+24] (codeMap)
+                emit({0x66, 0x83, 0x3C, 0x0A, 0x00});                       // cmp word [rdx+rcx], 0
+                stubs.push_back({emitJump({0x0F, 0x85}), pc + 2, EXIT_STORE_TO_CODE, false, true});
+                break;
+            case K_JAL:
+                if(in.rd != 0) {
+                    emit({0xC7, 0x43, slot(in.rd)});                        // mov dword [rd], return address
+                    emit32(pc + 2);
+                }
+                chains.push_back({emitJump({0xE9}), pc + 2 + in.imm});
+                break;
+            case K_BEQ: case K_BNE: case K_BLT: {
+                static const uint8_t conditions[] = {0x84, 0x85, 0x8C};     // je jne jl
+                loadEax(in.rs1);
+                emit({0x3B, 0x43, slot(in.rs2)});                           // cmp eax, [rs2]
+                chains.push_back({emitJump({0x0F, conditions[in.kind - K_BEQ]}), pc + 2 + in.imm});
+                chains.push_back({emitJump({0xE9}), pc + 2});
+                break;
+            }
+            case K_JR:
+                loadEax(in.rs1);
+                emitFaultChecks(pc, 1, Machine::MEMORY_BYTES - 1, stubs);
+                emit({0x49, 0x8B, 0x0C, 0x86});                             // mov rcx, [r14+rax*4]
+                emit({0x48, 0x85, 0xC9});                                   // test rcx, rcx
+                stubs.push_back({emitJump({0x0F, 0x84}), 0, EXIT_DISPATCH, true, false});    // jz
+                emit({0xFF, 0xE1});                                         // jmp rcx
+                break;
+        }
+    }
+
+    void emitStub(const ExitStub& stub, uint32_t block) {
+        bind(stub.site, codeUsed);
+        if(stub.dynamicPc) {
+            emit({0x41, 0x89, 0x45, 0x08});                                 // mov [r13+8], eax
+        } else {
+            storeContext(8, stub.pc);
+        }
+        if(stub.storeAddress) emit({0x41, 0x89, 0x45, 0x14});               // mov [r13+20], eax
+        storeContext(12, stub.reason);
+        storeContext(16, block);
+        bind(emitJump({0xE9}), exitOffset);
+    }
+
+    void* translate(uint32_t pc) {
+        std::vector<Instruction> instructions;
+        for(uint32_t address = pc; address < Machine::MEMORY_BYTES &&
+                                   instructions.size() < static_cast<size_t>(MAX_BLOCK_INSTRUCTIONS); address += 2) {
+            Instruction in = decode(machine.readHalf(address));
+            if(!translatable(in, address)) break;
+            instructions.push_back(in);
+            if(isControlTransfer(in.kind)) break;
+        }
+        if(instructions.empty()) return nullptr;
+        if(blocks.size() == static_cast<size_t>(MAX_BLOCKS) || codeUsed + 96 * MAX_BLOCK_INSTRUCTIONS > CODE_BYTES) {
+            flush();
+        }
+
+        uint32_t index = static_cast<uint32_t>(blocks.size());
+        uint32_t length = static_cast<uint32_t>(instructions.size());
+        size_t start = codeUsed;
+        std::vector<ExitStub> stubs;
+        std::vector<ChainExit> chains;
+
+        emit({0x49, 0x81, 0xFF});                                           // cmp r15, length
+        emit32(length);
+        stubs.push_back({emitJump({0x0F, 0x82}), pc, EXIT_BUDGET, false, false});   // jb
+        emit({0x49, 0x81, 0xEF});                                           // sub r15, length
+        emit32(length);
+        emit({0x49, 0xFF, 0x85});                                           // inc qword [r13+runs]
+        emit32(static_cast<uint32_t>(offsetof(Context, blockRuns) + 8 * index));
+
+        Block block;
+        block.pc = pc;
+        for(uint32_t i = 0; i < length; i++) {
+            emitInstruction(instructions[i], pc + 2 * i, stubs, chains);
+            block.kinds.push_back(instructions[i].kind);
+        }
+        if(!isControlTransfer(instructions.back().kind)) {
+            chains.push_back({emitJump({0xE9}), pc + 2 * length});
+        }
+
+        for(const auto& stub : stubs) emitStub(stub, index);
+        for(const auto& chain : chains) {
+            // A target past the end of memory exits to the dispatcher for
+            // good, which leaves the fault to the interpreter
+            bool inRange = chain.target < Machine::MEMORY_BYTES;
+            void* target = inRange ? table[chain.target >> 1] : nullptr;
+            if(target != nullptr) {
+                bind(chain.site, static_cast<uint8_t*>(target) - code);
+                chainsPatched++;
+                continue;
+            }
+            ExitStub stub = {chain.site, chain.target, EXIT_DISPATCH, false, false};
+            emitStub(stub, index);
+            if(inRange) pendingChains.insert(std::make_pair(chain.target, chain.site));
+        }
+
+        blocks.push_back(block);
+        context->blockRuns[index] = 0;
+        table[pc >> 1] = code + start;
+        for(uint32_t i = 0; i < length; i++) machine.codeMap[(pc >> 1) + i] = 1;
+        auto waiting = pendingChains.equal_range(pc);
+        for(auto it = waiting.first; it != waiting.second; ++it) {
+            bind(it->second, start);
+            chainsPatched++;
+        }
+        pendingChains.erase(waiting.first, waiting.second);
+        blocksTranslated++;
+        return code + start;
+    }
+
+    // Adds what the blocks executed to the machine's instruction mix
+    void collectCounts() {
+        for(size_t i = 0; i < blocks.size(); i++) {
+            uint64_t runs = context->blockRuns[i];
+            if(runs == 0) continue;
+            for(uint8_t kind : blocks[i].kinds) machine.kindCounts[kind] += runs;
+            context->blockRuns[i] = 0;
+        }
+    }
+
+    // A side exit left block after its first executed instructions; give
+    // back the budget and counts charged for the rest
+    void chargePartialBlock(uint32_t block, uint32_t executed) {
+        const Block& record = blocks[block];
+        context->blockRuns[block]--;
+        context->budget += record.kinds.size() - executed;
+        for(uint32_t i = 0; i < executed; i++) machine.kindCounts[record.kinds[i]]++;
+    }
+
+    void flush() {
+        collectCounts();
+        std::fill(table.begin(), table.end(), nullptr);
+        blocks.clear();
+        pendingChains.clear();
+        codeUsed = firstBlockOffset;
+        machine.codeModified = false;
+        cacheFlushes++;
+    }
+
+    // Runs at most budget instructions in the interpreter; returns how many retired
+    uint64_t interpret(uint64_t budget, Machine::Status& status) {
+        uint64_t before = machine.instret;
+        status = machine.run(budget);
+        uint64_t retired = machine.instret - before;
+        context->budget -= retired;
+        interpreterExits += retired;
+        return retired;
+    }
+
+public:
+    explicit Jit(Machine& target)
+        : blocksTranslated(0), chainsPatched(0), cacheFlushes(0), interpreterExits(0),
+          machine(target), context(new Context()), table(Machine::MEMORY_BYTES / 2, nullptr),
+          code(nullptr), codeUsed(0), firstBlockOffset(0), exitOffset(0), hasPopcnt(false),
+          translatedMacMode(MAC_WORD) {
+#if defined(ISA_JIT_X86_64)
+        void* buffer = mmap(nullptr, CODE_BYTES, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(buffer != MAP_FAILED) {
+            code = static_cast<uint8_t*>(buffer);
+            emitEntryAndExit();
+            __builtin_cpu_init();
+            hasPopcnt = __builtin_cpu_supports("popcnt");
+        }
+#endif
+    }
+
+    ~Jit() {
+#if defined(ISA_JIT_X86_64)
+        if(code != nullptr) munmap(code, CODE_BYTES);
+#endif
+    }
+
+    // False when this host has no backend (or executable memory was refused)
+    bool available() const { return code != nullptr; }
+
+    // Same contract as Machine::run
+    Machine::Status run(uint64_t maxInstructions) {
+        if(machine.status != Machine::RUNNING) return machine.status;
+        if(!available()) return machine.run(maxInstructions);
+
+        EntryFunction enter = reinterpret_cast<EntryFunction>(code);
+        Machine::Status status = Machine::RUNNING;
+        uint64_t interpreted = 0;
+        context->budget = maxInstructions;
+        context->codeMap = machine.codeMap.data();
+
+        while(status == Machine::RUNNING) {
+            if(machine.codeModified || machine.macMode != translatedMacMode) {
+                flush();
+                translatedMacMode = machine.macMode;
+            }
+            if(context->budget == 0) {
+                status = Machine::STEP_LIMIT;
+                break;
+            }
+            void* block = nullptr;
+            if(!machine.loopActive()) {
+                block = machine.pc < Machine::MEMORY_BYTES && !(machine.pc & 1) ? table[machine.pc >> 1] : nullptr;
+                if(block == nullptr) block = translate(machine.pc);
+            }
+            if(block == nullptr) {
+                interpreted += interpret(1, status);
+                if(status == Machine::STEP_LIMIT) status = Machine::RUNNING;
+                continue;
+            }
+
+            enter(machine.regs, machine.memory.data(), context.get(), table.data(), block);
+            machine.pc = context->pc;
+            switch(context->reason) {
+                case EXIT_DISPATCH:
+                    break;
+                case EXIT_BUDGET:
+                    interpreted += interpret(context->budget, status);
+                    break;
+                case EXIT_INTERPRET:
+                    chargePartialBlock(context->block, (context->pc - blocks[context->block].pc) / 2);
+                    interpreted += interpret(1, status);
+                    if(status == Machine::STEP_LIMIT) status = Machine::RUNNING;
+                    break;
+                case EXIT_STORE_TO_CODE:
+                    chargePartialBlock(context->block, (context->pc - blocks[context->block].pc) / 2);
+                    // Rewriting the word sends it through the machine's invalidation
+                    machine.writeWord(context->address, machine.readWord(context->address));
+                    break;
+            }
+        }
+
+        collectCounts();
+        machine.instret += maxInstructions - context->budget - interpreted;
+        return status;
+    }
+};
+
+} // namespace isa
+
+#endif
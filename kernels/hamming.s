@@ -0,0 +1,25 @@
+; hammingDistance (biometric): number of differing bits between two binary
+; templates, as used for hashed voiceprint/face signatures.
+;
+;   x1 = a, x2 = b, x3 = length in words  ->  x1 = popcount(a ^ b) summed
+;
+; There is no XOR between registers, so a ^ b is built as (a | b) - (a & b).
+
+        .global hammingDistance
+
+hammingDistance:
+        ADD     x4, x0, x0              ; distance = 0
+        BEQ     x3, x0, done
+loop:   LW      x5, 0(x1)
+        LW      x6, 0(x2)
+        OR      x7, x5, x6
+        AND     x5, x5, x6
+        SUB     x7, x7, x5              ; a ^ b
+        BCNT    x7, x7
+        ADD     x4, x4, x7
+        ADDI    x1, x1, 4
+        ADDI    x2, x2, 4
+        ADDI    x3, x3, -1
+        BNE     x3, x0, loop
+done:   MV      x1, x4
+        RET
@@ -0,0 +1,23 @@
+; hammingDistanceV: hammingDistance on the SIMD extension, VLENB bytes per
+; iteration at whatever width the core implements.
+;
+;   x1 = a, x2 = b, x3 = length in words  ->  x1 = popcount(a ^ b) summed
+;
+; length * 4 must be a multiple of VLENB.
+
+        .global hammingDistanceV
+
+hammingDistanceV:
+        VLENB   x5
+        ADD     x3, x3, x3
+        ADD     x3, x3, x3              ; bytes left
+        ADD     x4, x0, x0              ; distance = 0
+        BEQ     x3, x0, done
+loop:   VLD     v0, (x1)+
+        VLD     v1, (x2)+
+        SUB     x3, x3, x5
+        VXOR    v0, v1
+        VPOPC   x4, v0
+        BNE     x3, x0, loop
+done:   MV      x1, x4
+        RET
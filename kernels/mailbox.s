@@ -0,0 +1,23 @@
+; Mailbox shared between cores (multicore study): a value word and a
+; sequence word that every post bumps.
+;
+; postEvent:  x1 = mailbox, x2 = value  ->  x1 = new sequence number
+; readEvent:  x1 = mailbox              ->  x1 = sequence number, x2 = value
+;
+; Uses x1-x3 only.
+
+        .global postEvent
+        .global readEvent
+
+postEvent:
+        LW      x3, 4(x1)               ; sequence
+        ADDI    x3, x3, 1
+        SW      x2, 0(x1)
+        SW      x3, 4(x1)
+        ADD     x1, x3, x0
+        RET
+
+readEvent:
+        LW      x2, 0(x1)
+        LW      x1, 4(x1)
+        RET
@@ -0,0 +1,39 @@
+; matchKeywords (voice prototype): score a feature frame against each
+; keyword model and report whether any clears the response threshold.
+;
+;   x1 = features, x2 = first model, x3 = model count,
+;   x4 = length                          ->  x1 = 1 on a match, else 0
+;
+; Models are stored back to back. Features are Q4 and models Q8, so the
+; prototype's |similarity| / length > 0.85 becomes |dot| > 0.85 * 4096 *
+; length; the bound below is for its 256-element frames. State lives in
+; x7-x13 because computeSimilarity only uses x1-x6.
+
+        .global matchKeywords
+
+        .equ THRESHOLD, 891289          ; 0.85 * 4096 * 256, rounded down
+
+matchKeywords:
+        MV      x13, lr
+        MV      x9, x1                  ; features
+        MV      x10, x2                 ; current model
+        MV      x11, x3                 ; models left
+        MV      x12, x4                 ; length
+        ADD     x7, x4, x4
+        ADD     x7, x7, x7              ; model stride in bytes
+        LI      x8, THRESHOLD
+model:  BEQZ    x11, none
+        MV      x1, x9
+        MV      x2, x10
+        MV      x3, x12
+        CALL    computeSimilarity
+        BLT     x8, x1, match           ; dot > threshold
+        SUB     x1, x0, x1
+        BLT     x8, x1, match           ; -dot > threshold
+        ADD     x10, x10, x7
+        ADDI    x11, x11, -1
+        J       model
+none:   LI      x1, 0
+        JR      x13
+match:  LI      x1, 1
+        JR      x13
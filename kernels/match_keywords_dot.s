@@ -0,0 +1,46 @@
+; matchKeywordsDot4 / matchKeywordsDot2: matchKeywords on packed models and
+; features, four int8 or two int16 elements per word, with the experimental
+; fused dot-product MAC modes.
+;
+;   x1 = features, x2 = first model, x3 = model count,
+;   x4 = length in words                 ->  x1 = 1 on a match, else 0
+;
+; Under MACMODE 1 (2) the MAC in computeSimilarity is DOT4.B (DOT2.H), so
+; it returns the same dot product in a quarter (half) of the iterations.
+; The threshold is matchKeywords' because elements keep their Q4/Q8
+; scaling. MACMODE is back to 0 on return.
+
+        .global matchKeywordsDot4
+        .global matchKeywordsDot2
+
+        .equ THRESHOLD, 891289          ; 0.85 * 4096 * 256, rounded down
+
+matchKeywordsDot4:
+        MACMODE 1
+        J       start
+matchKeywordsDot2:
+        MACMODE 2
+start:  MV      x13, lr
+        MV      x9, x1                  ; features
+        MV      x10, x2                 ; current model
+        MV      x11, x3                 ; models left
+        MV      x12, x4                 ; words per model
+        ADD     x7, x4, x4
+        ADD     x7, x7, x7              ; model stride in bytes
+        LI      x8, THRESHOLD
+model:  BEQZ    x11, none
+        MV      x1, x9
+        MV      x2, x10
+        MV      x3, x12
+        CALL    computeSimilarity
+        BLT     x8, x1, match           ; dot > threshold
+        SUB     x1, x0, x1
+        BLT     x8, x1, match           ; -dot > threshold
+        ADD     x10, x10, x7
+        ADDI    x11, x11, -1
+        J       model
+none:   LI      x1, 0
+        J       exit
+match:  LI      x1, 1
+exit:   MACMODE 0
+        JR      x13
@@ -0,0 +1,55 @@
+; runSchedule (sampled simulation): a long session as one program. The host
+; lays out a schedule of kernel calls, one 32-byte record each: entry,
+; x1-x5, and a result word this fills in. Every pass runs the whole
+; schedule in order.
+;
+;   x1 = first record, x2 = record count, x3 = passes  ->  x1 = 0
+;
+; The kernels may use every register but sp, so the state lives on the
+; stack: 0 lr, 4 first record, 8 record count, 12 passes left, 16 next
+; record, 20 records left in this pass.
+
+        .global runSchedule
+
+runSchedule:
+        ADDI    sp, sp, -8
+        ADDI    sp, sp, -8
+        ADDI    sp, sp, -8
+        SW      lr, 0(sp)
+        SW      x1, 4(sp)
+        SW      x2, 8(sp)
+        SW      x3, 12(sp)
+pass:   LW      x7, 12(sp)
+        BEQZ    x7, done
+        ADDI    x7, x7, -1
+        SW      x7, 12(sp)
+        LW      x7, 4(sp)
+        SW      x7, 16(sp)
+        LW      x7, 8(sp)
+        SW      x7, 20(sp)
+call:   LW      x7, 20(sp)
+        BEQZ    x7, pass
+        ADDI    x7, x7, -1
+        SW      x7, 20(sp)
+        LW      x7, 16(sp)
+        LW      x8, 0(x7)               ; entry
+        LW      x1, 4(x7)
+        LW      x2, 8(x7)
+        LW      x3, 12(x7)
+        LW      x4, 16(x7)
+        LW      x5, 20(x7)
+        LA      lr, back
+        JR      x8
+back:   LW      x7, 16(sp)
+        SW      x1, 24(x7)              ; result
+        LI      x8, 32
+        ADD     x7, x7, x8
+        SW      x7, 16(sp)
+        J       call
+done:   LW      lr, 0(sp)
+        ADDI    sp, sp, 6
+        ADDI    sp, sp, 6
+        ADDI    sp, sp, 6
+        ADDI    sp, sp, 6
+        LI      x1, 0
+        RET
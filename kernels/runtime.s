@@ -0,0 +1,9 @@
+; Runtime support, linked first so it sits at address 0.
+;
+; The host points lr at powerOff before calling a kernel, so the kernel's
+; RET switches the core off and ends the simulation.
+
+        .global powerOff
+
+powerOff:
+        HALT
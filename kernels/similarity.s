@@ -0,0 +1,21 @@
+; computeSimilarity (voice prototype): dot product of a feature frame and
+; a keyword model.
+;
+;   x1 = features, x2 = model, x3 = length  ->  x1 = sum of features[i] * model[i]
+;
+; Uses x1-x6 only.
+
+        .global computeSimilarity
+
+computeSimilarity:
+        ADD     x4, x0, x0              ; acc = 0
+        BEQ     x3, x0, done
+loop:   LW      x5, 0(x1)
+        LW      x6, 0(x2)
+        MAC     x4, x5, x6
+        ADDI    x1, x1, 4
+        ADDI    x2, x2, 4
+        ADDI    x3, x3, -1
+        BNE     x3, x0, loop
+done:   ADD     x1, x4, x0
+        RET
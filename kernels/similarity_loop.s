@@ -0,0 +1,20 @@
+; computeSimilarityLoop (voice prototype): computeSimilarity on the
+; experimental hardware loop. The body is computeSimilarity's without the
+; counter update and BNE, so each element costs five instructions, not seven.
+;
+;   x1 = features, x2 = model, x3 = length  ->  x1 = sum of features[i] * model[i]
+;
+; Uses x1-x6 only.
+
+        .global computeSimilarityLoop
+
+computeSimilarityLoop:
+        ADD     x4, x0, x0              ; acc = 0
+        LOOP    x3, done                ; length 0 skips the body
+        LW      x5, 0(x1)
+        LW      x6, 0(x2)
+        MAC     x4, x5, x6
+        ADDI    x1, x1, 4
+        ADDI    x2, x2, 4
+done:   ADD     x1, x4, x0
+        RET
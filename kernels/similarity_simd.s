@@ -0,0 +1,21 @@
+; computeSimilarityV: computeSimilarity on the SIMD extension, VLENB / 4
+; products per VMAC into the lane accumulators.
+;
+;   x1 = features, x2 = model, x3 = length  ->  x1 = sum of features[i] * model[i]
+;
+; length * 4 must be a multiple of VLENB. Uses x1-x6 only.
+
+        .global computeSimilarityV
+
+computeSimilarityV:
+        VLENB   x4
+        ADD     x3, x3, x3
+        ADD     x3, x3, x3              ; bytes left
+        BEQ     x3, x0, done
+loop:   VLD     v0, (x1)+
+        VLD     v1, (x2)+
+        SUB     x3, x3, x4
+        VMAC    v0, v1
+        BNE     x3, x0, loop
+done:   VREDSUM x1
+        RET
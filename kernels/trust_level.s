@@ -0,0 +1,59 @@
+; evaluateTrustLevel (connectivity prototype): count trusted devices in a
+; scan and map the count and location to a trust level.
+;
+;   x1 = nearby device ids,  x2 = count,
+;   x3 = trusted device ids, x4 = count,
+;   x5 = location id                     ->  x1 = TrustLevelId
+
+        .global evaluateTrustLevel
+
+        .equ LOCATION_HOME, 0
+        .equ LOCATION_OFFICE, 1
+        .equ LOCATION_RURAL, 5
+        .equ TRUST_HOME, 0
+        .equ TRUST_PUBLIC, 1
+        .equ TRUST_UNTRUSTED, 2
+        .equ TRUST_EMERGENCY, 3
+
+evaluateTrustLevel:
+        ADD     x9, x0, x0              ; trusted count
+outer:  BNE     x2, x0, body
+        J       decide
+body:   LW      x6, 0(x1)               ; nearby device id
+        MV      x7, x3
+        MV      x8, x4
+        BEQ     x8, x0, next
+inner:  LW      x10, 0(x7)
+        BNE     x10, x6, miss
+        ADDI    x9, x9, 1
+        J       next
+miss:   ADDI    x7, x7, 4
+        ADDI    x8, x8, -1
+        BNE     x8, x0, inner
+next:   ADDI    x1, x1, 4
+        ADDI    x2, x2, -1
+        J       outer
+
+decide: BNE     x5, x0, notHome         ; LOCATION_HOME is 0
+        LI      x6, 2
+        BLT     x9, x6, notHome
+        LI      x1, TRUST_HOME
+        RET
+notHome:
+        LI      x6, LOCATION_OFFICE
+        BNE     x5, x6, notOffice
+        BEQ     x9, x0, notOffice
+        LI      x1, TRUST_PUBLIC
+        RET
+notOffice:
+        BEQ     x9, x0, noTrusted
+        LI      x1, TRUST_PUBLIC
+        RET
+noTrusted:
+        LI      x6, LOCATION_RURAL
+        BNE     x5, x6, untrusted
+        LI      x1, TRUST_EMERGENCY
+        RET
+untrusted:
+        LI      x1, TRUST_UNTRUSTED
+        RET
@@ -0,0 +1,28 @@
+; isTrustedEnvironment (biometric prototype): is any of the profile's
+; trusted devices among the nearby ones?
+;
+;   x1 = profile device ids, x2 = count,
+;   x3 = nearby device ids,  x4 = count  ->  x1 = 1 if trusted, else 0
+
+        .global isTrustedEnvironment
+
+isTrustedEnvironment:
+        ADD     x9, x0, x0              ; found = 0
+        J       outer
+found:  ADDI    x9, x0, 1
+done:   MV      x1, x9
+        RET
+outer:  BEQ     x2, x0, done
+        LW      x5, 0(x1)               ; trusted device id
+        MV      x6, x3
+        MV      x7, x4
+        BEQ     x7, x0, next
+inner:  LW      x8, 0(x6)
+        BNE     x8, x5, miss
+        J       found
+miss:   ADDI    x6, x6, 4
+        ADDI    x7, x7, -1
+        BNE     x7, x0, inner
+next:   ADDI    x1, x1, 4
+        ADDI    x2, x2, -1
+        J       outer
@@ -0,0 +1,59 @@
+; voiceService (voice prototype, interrupt-driven): the DMA engine fills a
+; ring of feature frames without the core and raises a frame-complete
+; interrupt; the core sleeps in SLEEPM 1 until then, scores every new
+; frame with matchKeywords and tells the DMA engine it is done with it.
+;
+;   x1 = control block                   ->  x1 = frames with a keyword
+;
+; Control block (words): 0 frames produced (DMA), 1 frames consumed (core),
+; 2 ring base, 3 ring slots - 1, 4 frame words, 5 first model, 6 model
+; count, 7 frames to serve. The ring has a power-of-two number of slots.
+;
+; matchKeywords uses every register but sp and lr, so the control block
+; pointer, lr and the running count live on the stack. It is linked too far
+; away for CALL, so lr is loaded by hand. The produced count is checked
+; before sleeping: an interrupt that lands between the check and SLEEPM
+; makes SLEEPM fall straight through.
+
+        .global voiceService
+
+voiceService:
+        ADDI    sp, sp, -8
+        ADDI    sp, sp, -4
+        SW      lr, 0(sp)
+        SW      x1, 4(sp)               ; control block
+        SW      x0, 8(sp)               ; keywords detected
+next:   LW      x1, 4(sp)
+        LW      x3, 4(x1)               ; consumed
+        LW      x4, 28(x1)              ; frames to serve
+        BEQ     x3, x4, done
+wait:   LW      x2, 0(x1)               ; produced
+        BNE     x2, x3, frame
+        SLEEPM  1                       ; until the frame-complete interrupt
+        J       wait
+frame:  LW      x5, 12(x1)              ; slot mask
+        AND     x5, x3, x5
+        LW      x4, 16(x1)              ; frame words, also the length
+        ADD     x6, x4, x4
+        ADD     x6, x6, x6              ; frame bytes
+        LW      x7, 8(x1)               ; ring base
+        MAC     x7, x5, x6              ; oldest unserved frame
+        LW      x2, 20(x1)              ; first model
+        LW      x3, 24(x1)              ; model count
+        MV      x1, x7
+        LA      x8, matchKeywords       ; out of JAL range from here
+        LA      lr, scored
+        JR      x8
+scored: LW      x2, 8(sp)
+        ADD     x2, x2, x1
+        SW      x2, 8(sp)
+        LW      x1, 4(sp)
+        LW      x3, 4(x1)
+        ADDI    x3, x3, 1
+        SW      x3, 4(x1)               ; the slot is free for the DMA engine
+        J       next
+done:   LW      x1, 8(sp)
+        LW      lr, 0(sp)
+        ADDI    sp, sp, 6
+        ADDI    sp, sp, 6
+        RET
@@ -0,0 +1,133 @@
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "iss.h"
+#include "pipeline.h"
+#include "cache.h"
+
+// N copies of the in-order core. Each is a functional Machine timed by its
+// own Pipeline with private L1I/L1D, and all of them share the L2 over the
+// MSI snooping bus in cache.h. step() clocks every busy core once, in
+// lockstep, so cores contend for the bus cycle by cycle.
+//
+// Functional memory stays private to each Machine while the caches see one
+// physical address space: cores work in disjoint regions, and data they
+// really share (a mailbox) is copied to the other Machines by publish()
+// once the writer's call has finished.
+//
+// Cores need not be alike: the CoreConfig constructor builds a
+// heterogeneous system (a dual-issue core next to a minimal one). The L2,
+// DRAM and bus come from the first core's HierarchyConfig.
+namespace isa {
+
+struct CoreConfig {
+    std::string name;
+    PipelineConfig pipeline;    // memory and predictor are set per core
+    HierarchyConfig memory;
+
+    CoreConfig(const std::string& label = "core", const PipelineConfig& timing = PipelineConfig(),
+               const HierarchyConfig& caches = HierarchyConfig())
+        : name(label), pipeline(timing), memory(caches) {}
+};
+
+class MultiCore {
+public:
+    struct Core {
+        std::string name;
+        Machine machine;
+        MemoryHierarchy memory;
+        Pipeline pipeline;
+        bool busy;              // a call is running
+
+        explicit Core(const CoreConfig& config)
+            : name(config.name), memory(config.memory), pipeline(machine, config.pipeline), busy(false) {
+            pipeline.setMemory(&memory);
+        }
+    };
+
+private:
+    std::vector<std::unique_ptr<Core>> cores;
+
+public:
+    SnoopingBus bus;
+    uint64_t clock;
+
+    // Every core starts with a copy of image's memory (the linked kernels)
+    MultiCore(const std::vector<CoreConfig>& configs, const Machine& image, const BusConfig& busConfig)
+        : bus(configs.front().memory, busConfig), clock(0) {
+        for(const auto& config : configs) {
+            cores.emplace_back(new Core(config));
+            cores.back()->machine.loadBytes(image.memory, 0);
+            cores.back()->memory.joinBus(bus);
+        }
+    }
+
+    // count identical baseline cores
+    MultiCore(int count, const Machine& image, const HierarchyConfig& config, const BusConfig& busConfig)
+        : MultiCore(std::vector<CoreConfig>(count, CoreConfig("core", PipelineConfig(), config)), image, busConfig) {}
+
+    int size() const { return static_cast<int>(cores.size()); }
+    Core& core(int i) { return *cores[i]; }
+
+    bool idle() const {
+        for(const auto& core : cores) {
+            if(core->busy) return false;
+        }
+        return true;
+    }
+
+    // Calls the function at entry on core i with args in x1.., returning to
+    // returnAddress (which should power the core off)
+    void start(int i, uint32_t entry, const std::vector<uint32_t>& args, uint32_t returnAddress) {
+        Core& target = *cores[i];
+        target.machine.reset();
+        for(size_t arg = 0; arg < args.size(); arg++) target.machine.regs[1 + arg] = args[arg];
+        target.machine.regs[REG_LR] = returnAddress;
+        target.machine.pc = entry;
+        target.pipeline.reset(entry);
+        target.busy = true;
+    }
+
+    // Host (DMA) write into core i's memory; its cached copies go stale
+    void writeWords(int i, uint32_t address, const std::vector<uint32_t>& words) {
+        Core& target = *cores[i];
+        for(size_t word = 0; word < words.size(); word++) target.machine.writeWord(address + 4 * word, words[word]);
+        target.memory.invalidate(address, static_cast<uint32_t>(4 * words.size()));
+    }
+
+    // Copies bytes that core from wrote to every other core's memory
+    void publish(int from, uint32_t address, uint32_t bytes) {
+        const std::vector<uint8_t>& source = cores[from]->machine.memory;
+        std::vector<uint8_t> data(source.begin() + address, source.begin() + address + bytes);
+        for(int i = 0; i < size(); i++) {
+            if(i != from) cores[i]->machine.loadBytes(data, address);
+        }
+    }
+
+    // One clock for every busy core
+    void step() {
+        bus.now = clock;
+        for(auto& core : cores) {
+            if(core->busy) core->busy = core->pipeline.cycle();
+        }
+        clock++;
+    }
+
+    // Cycles core i has not been clocked so far: asleep or waiting for work
+    uint64_t sleepCycles(int i) const {
+        return clock - cores[i]->pipeline.stats.cycles;
+    }
+
+    // All cores asleep until cycle
+    void sleepUntil(uint64_t cycle) {
+        if(cycle > clock) clock = cycle;
+    }
+};
+
+} // namespace isa
+
+#endif
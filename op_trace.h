@@ -0,0 +1,275 @@
+#ifndef OP_TRACE_H
+#define OP_TRACE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstdlib>
+
+// Abstract operation traces from the C++ prototypes, for trace-driven runs
+// of the cache and pipeline models without porting code to assembly.
+// Instrumented code asks recorder() once per call and, when a capture is
+// running on its thread, records what the kernel does: loads and stores
+// with their host addresses, ALU operations, MACs, compares, popcounts,
+// branches with their outcome, and a mark where each kernel call starts.
+//
+// Records are one byte, plus a varint for memory addresses that are not
+// near a recent one:
+//
+//   bits 2:0  OpKind
+//   LOAD/STORE  bits 4:3  address stream (the encoder keeps four)
+//               bits 7:5  zigzag(delta / 4) from that stream's last address,
+//                         7 = zigzag(delta) follows as a LEB128 varint
+//   BRANCH      bit 3     taken, bits 7:4 branch site (0-15, per kernel)
+//   MARK        bits 7:3  TraceKernel
+//
+// A file is "OPTR", a version byte, then the record count and the byte
+// count as little-endian uint64, then the records.
+namespace optrace {
+
+enum OpKind {
+    OP_LOAD = 0, OP_STORE, OP_ALU, OP_MAC, OP_COMPARE, OP_BRANCH, OP_POPCOUNT, OP_MARK,
+    OP_KIND_COUNT
+};
+
+// Kernels the prototypes trace; a MARK starts one call
+enum TraceKernel {
+    KERNEL_MATCH_KEYWORDS = 0, KERNEL_TRUSTED_ENVIRONMENT, KERNEL_CONNECTIVITY_DECISIONS,
+    TRACE_KERNEL_COUNT
+};
+
+inline const char* opKindName(int kind) {
+    static const char* names[OP_KIND_COUNT] = {
+        "load", "store", "ALU", "MAC", "compare", "branch", "popcount", "mark"
+    };
+    return names[kind];
+}
+
+inline const char* traceKernelName(int kernel) {
+    static const char* names[TRACE_KERNEL_COUNT] = {
+        "matchKeywords", "isTrustedEnvironment", "makeConnectivityDecisions"
+    };
+    return kernel < TRACE_KERNEL_COUNT ? names[kernel] : "unknown";
+}
+
+struct Record {
+    uint8_t kind;
+    uint8_t site;       // BRANCH: branch site, MARK: TraceKernel
+    bool taken;
+    uint64_t address;   // LOAD/STORE
+};
+
+const int STREAMS = 4;
+const uint8_t VERSION = 1;
+
+class Recorder {
+private:
+    std::vector<uint8_t> bytes;
+    uint64_t records;
+    uint64_t lastAddress[STREAMS];
+    uint64_t lastUse[STREAMS];
+
+    void put(uint8_t byte) {
+        bytes.push_back(byte);
+        records++;
+        kindCounts[byte & 7]++;
+    }
+
+    void memory(OpKind kind, const void* pointer) {
+        uint64_t address = reinterpret_cast<uintptr_t>(pointer);
+        // Nearest stream if the delta fits in the record byte, else the
+        // least recently used
+        int stream = 0;
+        uint64_t nearest = UINT64_MAX;
+        for(int s = 0; s < STREAMS; s++) {
+            uint64_t distance = address > lastAddress[s] ? address - lastAddress[s] : lastAddress[s] - address;
+            if(distance < nearest) {
+                nearest = distance;
+                stream = s;
+            }
+        }
+        if(nearest > 12 || nearest % 4 != 0) {
+            for(int s = 1; s < STREAMS; s++) {
+                if(lastUse[s] < lastUse[stream]) stream = s;
+            }
+        }
+        int64_t delta = static_cast<int64_t>(address - lastAddress[stream]);
+        uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+        uint64_t words = (static_cast<uint64_t>(delta / 4) << 1) ^ static_cast<uint64_t>((delta / 4) >> 63);
+        bool small = delta % 4 == 0 && words < 7;
+        put(static_cast<uint8_t>(kind | (stream << 3) | ((small ? words : 7) << 5)));
+        if(!small) {
+            for(; zigzag >= 0x80; zigzag >>= 7) bytes.push_back(static_cast<uint8_t>(zigzag | 0x80));
+            bytes.push_back(static_cast<uint8_t>(zigzag));
+        }
+        lastAddress[stream] = address;
+        lastUse[stream] = records;
+    }
+
+public:
+    uint64_t kindCounts[OP_KIND_COUNT];
+
+    Recorder() { clear(); }
+
+    void clear() {
+        bytes.clear();
+        records = 0;
+        for(int s = 0; s < STREAMS; s++) lastAddress[s] = lastUse[s] = 0;
+        for(auto& count : kindCounts) count = 0;
+    }
+
+    void load(const void* address) { memory(OP_LOAD, address); }
+    void store(const void* address) { memory(OP_STORE, address); }
+    void alu() { put(OP_ALU); }
+    void mac() { put(OP_MAC); }
+    void compare() { put(OP_COMPARE); }
+    void popcount() { put(OP_POPCOUNT); }
+    void mark(TraceKernel kernel) { put(static_cast<uint8_t>(OP_MARK | (kernel << 3))); }
+
+    void branch(int site, bool taken) {
+        put(static_cast<uint8_t>(OP_BRANCH | (taken ? 8 : 0) | ((site & 15) << 4)));
+    }
+
+    uint64_t recordCount() const { return records; }
+    size_t byteCount() const { return bytes.size(); }
+
+    bool save(const std::string& path, std::string& error) const {
+        std::ofstream out(path.c_str(), std::ios::binary);
+        if(!out) {
+            error = "cannot create " + path;
+            return false;
+        }
+        uint8_t header[21] = {'O', 'P', 'T', 'R', VERSION};
+        uint64_t size = bytes.size();
+        for(int i = 0; i < 8; i++) {
+            header[5 + i] = static_cast<uint8_t>(records >> (8 * i));
+            header[13 + i] = static_cast<uint8_t>(size >> (8 * i));
+        }
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        if(!out) {
+            error = "write to " + path + " failed";
+            return false;
+        }
+        return true;
+    }
+};
+
+// The recorder capturing on this thread, or nullptr
+inline Recorder*& activeRecorder() {
+    thread_local Recorder* recorder = nullptr;
+    return recorder;
+}
+
+inline Recorder* recorder() {
+    return activeRecorder();
+}
+
+// Records everything this thread does while in scope
+class Capture {
+private:
+    Recorder* previous;
+
+public:
+    explicit Capture(Recorder& target) : previous(activeRecorder()) {
+        activeRecorder() = &target;
+    }
+
+    ~Capture() {
+        activeRecorder() = previous;
+    }
+};
+
+// Records a compare and the branch on its result when trace is set;
+// returns taken so it can wrap the condition it traces
+inline bool compareBranch(Recorder* trace, int site, bool taken) {
+    if(trace) {
+        trace->compare();
+        trace->branch(site, taken);
+    }
+    return taken;
+}
+
+class Reader {
+private:
+    std::vector<uint8_t> bytes;
+    size_t position;
+    uint64_t records;
+    uint64_t lastAddress[STREAMS];
+
+public:
+    Reader() : position(0), records(0) { rewind(); }
+
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        uint8_t header[21];
+        if(!in || !in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+            error = "cannot read " + path;
+            return false;
+        }
+        if(header[0] != 'O' || header[1] != 'P' || header[2] != 'T' || header[3] != 'R' || header[4] != VERSION) {
+            error = path + " is not a version " + std::to_string(VERSION) + " operation trace";
+            return false;
+        }
+        uint64_t size = 0;
+        records = 0;
+        for(int i = 7; i >= 0; i--) {
+            records = (records << 8) | header[5 + i];
+            size = (size << 8) | header[13 + i];
+        }
+        bytes.resize(size);
+        if(!in.read(reinterpret_cast<char*>(bytes.data()), size)) {
+            error = path + " is truncated";
+            return false;
+        }
+        rewind();
+        return true;
+    }
+
+    uint64_t recordCount() const { return records; }
+    size_t byteCount() const { return bytes.size(); }
+
+    void rewind() {
+        position = 0;
+        for(auto& address : lastAddress) address = 0;
+    }
+
+    // False at the end of the trace
+    bool next(Record& record) {
+        if(position >= bytes.size()) return false;
+        uint8_t byte = bytes[position++];
+        record.kind = byte & 7;
+        record.site = 0;
+        record.taken = false;
+        record.address = 0;
+        if(record.kind == OP_LOAD || record.kind == OP_STORE) {
+            int stream = (byte >> 3) & 3;
+            uint64_t code = byte >> 5;
+            int64_t delta;
+            if(code < 7) {
+                delta = 4 * static_cast<int64_t>((code >> 1) ^ (~(code & 1) + 1));
+            } else {
+                uint64_t zigzag = 0;
+                for(int shift = 0; position < bytes.size(); shift += 7) {
+                    uint8_t part = bytes[position++];
+                    zigzag |= static_cast<uint64_t>(part & 0x7F) << shift;
+                    if(!(part & 0x80)) break;
+                }
+                delta = static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+            }
+            lastAddress[stream] += static_cast<uint64_t>(delta);
+            record.address = lastAddress[stream];
+        } else if(record.kind == OP_BRANCH) {
+            record.taken = (byte & 8) != 0;
+            record.site = byte >> 4;
+        } else if(record.kind == OP_MARK) {
+            record.site = byte >> 3;
+        }
+        return true;
+    }
+};
+
+} // namespace optrace
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef PERIPHERALS_H
+#define PERIPHERALS_H
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include "iss.h"
+#include "cache.h"
+
+// Devices around the core for the interrupt-driven voice loop: a DMA engine
+// that moves words from a device FIFO (the audio front end) into a ring of
+// frames in data memory without the core, and an interrupt controller that
+// turns its frame-complete event into a SLEEPM wake-up.
+//
+// The ISS has no I/O address decode, so the DMA engine's registers are a
+// control block in data memory (DmaControl): it publishes how many frames
+// it has completed and reads back how many the core has consumed. A frame
+// that would overwrite one the core has not consumed is dropped and
+// counted as an overrun. Devices are clocked by the host between core
+// cycles, with the core's cycle count as the time.
+namespace isa {
+
+enum InterruptLine {
+    IRQ_DMA_FRAME = 0,      // the DMA engine completed a frame
+    IRQ_LINES
+};
+
+class InterruptController {
+private:
+    Machine& machine;
+    uint32_t enabled;
+
+public:
+    uint64_t raised[IRQ_LINES];
+    uint64_t wakeups;           // raises that found the core asleep
+
+    explicit InterruptController(Machine& core) : machine(core), enabled(0), wakeups(0) {
+        for(auto& count : raised) count = 0;
+    }
+
+    void enable(InterruptLine line) {
+        enabled |= 1u << line;
+    }
+
+    void raise(InterruptLine line) {
+        raised[line]++;
+        if(!(enabled & (1u << line))) return;
+        if(machine.status == Machine::SLEEPING) wakeups++;
+        machine.interrupt();
+    }
+};
+
+// Words of the control block the DMA engine shares with the core
+enum DmaControl {
+    DMA_PRODUCED = 0,       // frames completed (DMA writes)
+    DMA_CONSUMED,           // frames the core is done with (core writes)
+    DMA_RING,               // ring base address
+    DMA_SLOT_MASK,          // ring slots - 1
+    DMA_FRAME_WORDS,
+    DMA_CONTROL_WORDS
+};
+
+struct DmaConfig {
+    uint32_t control;           // control block address
+    uint32_t ring;
+    uint32_t slots;             // a power of two
+    uint32_t frameWords;
+    uint64_t cyclesPerWord;     // the device FIFO's rate
+
+    DmaConfig(uint32_t controlAddress, uint32_t ringAddress, uint32_t ringSlots, uint32_t words, uint64_t cycles)
+        : control(controlAddress), ring(ringAddress), slots(ringSlots), frameWords(words), cyclesPerWord(cycles) {}
+};
+
+class DmaEngine {
+private:
+    Machine& machine;
+    InterruptController& interrupts;
+    DmaConfig config;
+    MemoryHierarchy* memory;    // caches to keep coherent with the transfers
+    std::deque<uint32_t> fifo;
+    uint64_t nextTransfer;
+    uint32_t word;              // next word of the current frame
+    uint32_t produced;
+    bool dropping;              // the current frame is an overrun
+
+    void transfer() {
+        if(word == 0) {
+            dropping = produced - machine.readWord(config.control + 4 * DMA_CONSUMED) >= config.slots;
+        }
+        uint32_t value = fifo.front();
+        fifo.pop_front();
+        if(!dropping) {
+            uint32_t address = config.ring + 4 * ((produced & (config.slots - 1)) * config.frameWords + word);
+            machine.writeWord(address, value);
+            if(memory != nullptr) memory->invalidate(address, 4);
+            wordsMoved++;
+        }
+        if(++word < config.frameWords) return;
+        word = 0;
+        if(dropping) {
+            overruns++;
+            return;
+        }
+        machine.writeWord(config.control + 4 * DMA_PRODUCED, ++produced);
+        if(memory != nullptr) memory->invalidate(config.control + 4 * DMA_PRODUCED, 4);
+        completedAt.push_back(nextTransfer);
+        interrupts.raise(IRQ_DMA_FRAME);
+    }
+
+public:
+    uint64_t wordsMoved;
+    uint64_t overruns;                  // frames dropped on a full ring
+    std::vector<uint64_t> completedAt;  // cycle each frame completed
+
+    DmaEngine(Machine& core, InterruptController& controller, const DmaConfig& settings,
+              MemoryHierarchy* caches = nullptr)
+        : machine(core), interrupts(controller), config(settings), memory(caches), nextTransfer(0), word(0),
+          produced(0), dropping(false), wordsMoved(0), overruns(0) {}
+
+    // Writes the control block and starts transferring at cycle now
+    void start(uint64_t now) {
+        const uint32_t block[DMA_CONTROL_WORDS] = {0, 0, config.ring, config.slots - 1, config.frameWords};
+        for(int i = 0; i < DMA_CONTROL_WORDS; i++) machine.writeWord(config.control + 4 * i, block[i]);
+        if(memory != nullptr) memory->invalidate(config.control, 4 * DMA_CONTROL_WORDS);
+        nextTransfer = now + config.cyclesPerWord;
+        word = 0;
+        produced = 0;
+    }
+
+    // Words the device will deliver, in order
+    void feed(const std::vector<uint32_t>& words) {
+        fifo.insert(fifo.end(), words.begin(), words.end());
+    }
+
+    // Makes every transfer due by cycle now
+    void clock(uint64_t now) {
+        while(!fifo.empty() && nextTransfer <= now) {
+            transfer();
+            nextTransfer += config.cyclesPerWord;
+        }
+    }
+
+    // Cycle of the next transfer, or UINT64_MAX once the FIFO is empty
+    uint64_t nextEvent() const {
+        return fifo.empty() ? UINT64_MAX : nextTransfer;
+    }
+};
+
+} // namespace isa
+
+#endif
@@ -0,0 +1,603 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include "isa.h"
+#include "iss.h"
+#include "cache.h"
+#include "branch_predictor.h"
+#include "power_model.h"
+
+// Cycle-level model of the 5-stage IF/ID/EX/MEM/WB pipeline from the
+// Microarchitecture Specification, layered on the functional ISS: each
+// instruction executes in the Machine when it enters EX, so architectural
+// results are the ISS's and this class only decides when things happen.
+//
+//  - Forwarding from EX/MEM and MEM/WB covers ALU results, so only a load
+//    followed by a consumer stalls (until the load leaves MEM).
+//  - Fetch predicts not-taken, or asks the attached BranchPredictor;
+//    branches and jumps resolve in EX and a mispredicted one squashes the
+//    two younger instructions in IF and ID.
+//  - MAC holds EX for macLatency cycles; loads and stores hold MEM for
+//    memLatency cycles, or for as long as the L1D/L2/DRAM hierarchy says
+//    when one is attached, which also times every fetch through the L1I.
+//  - The register file writes in the first half-cycle and reads in the
+//    second, so WB -> ID needs no forwarding.
+//  - Fetch keeps its own copy of the hardware loop registers, armed when
+//    LOOP executes, and goes back to the top of the body without a bubble.
+//    From the second iteration the body comes from a MAX_LOOP_BODY-entry
+//    loop buffer instead of the instruction memory. Whenever EX finds the
+//    next pc differs from where fetch went, IF/ID are squashed and fetch
+//    restarts from the Machine's state.
+//  - Per-cycle activity (fetches, register ports, unit operations, clocked
+//    and gated stages) is counted for power_model.h.
+//  - With issueWidth 2 (a dual-issue configuration) fetch is 32 bits wide
+//    and a simple ALU instruction that does not depend on the one entering
+//    EX issues alongside it in a second lane.
+//  - A SLEEPM that puts the Machine to sleep (Machine::wakeOnInterrupt)
+//    squashes what was fetched after it; once the pipeline has drained,
+//    cycles count as sleep until an interrupt wakes the Machine and fetch
+//    restarts after the SLEEPM.
+//  - replay() drives the same timing from a StepSource instead of the
+//    Machine: fetch takes the recorded instructions in order, and after a
+//    mispredicted branch fetches NOPs down the predicted path until the
+//    branch resolves in EX and squashes them.
+namespace isa {
+
+// One instruction of a trace-driven run: what ran at pc, the address a
+// load or store touched, and whether a branch was taken
+struct TraceStep {
+    uint32_t pc;
+    Instruction in;
+    uint32_t address;
+    bool taken;
+};
+
+// Supplies a trace-driven run's instructions in program order
+class StepSource {
+public:
+    virtual ~StepSource() {}
+    virtual bool next(TraceStep& step) = 0;   // false at the end of the trace
+};
+
+struct PipelineConfig {
+    int macLatency;
+    int memLatency;
+    int issueWidth;             // 1 or 2
+    MemoryHierarchy* memory;    // nullptr: single-cycle fetch, memLatency MEM
+    BranchPredictor* predictor; // nullptr: predict not-taken
+
+    PipelineConfig() : macLatency(2), memLatency(1), issueWidth(1), memory(nullptr), predictor(nullptr) {}
+};
+
+struct PipelineStats {
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t loadUseStalls;        // cycles ID waited on a load in MEM that was not missing
+    uint64_t macStalls;            // cycles a MAC held EX beyond the first
+    uint64_t memStalls;            // cycles a memory access held MEM beyond the first
+    uint64_t fetchStalls;          // cycles IF waited on an instruction cache miss
+    uint64_t flushedInstructions;  // wrong-path instructions squashed in IF/ID
+    uint64_t controlTransfers;
+    uint64_t takenTransfers;
+    uint64_t mispredictions;       // control transfers fetch got wrong (each flushes IF/ID)
+    uint64_t conditionalBranches;
+    uint64_t conditionalMispredictions;
+    uint64_t threeReadIssues;      // instructions that needed three read ports (MAC)
+    uint64_t pairedIssues;         // instructions issued in the second lane
+    uint64_t sleepCycles;          // cycles asleep in SLEEPM waiting for an interrupt
+    Activity activity;
+
+    PipelineStats() { clear(); }
+
+    void clear() {
+        cycles = instructions = loadUseStalls = macStalls = memStalls = fetchStalls = 0;
+        flushedInstructions = controlTransfers = takenTransfers = 0;
+        mispredictions = conditionalBranches = conditionalMispredictions = 0;
+        threeReadIssues = pairedIssues = sleepCycles = 0;
+        activity.clear();
+    }
+
+    void add(const PipelineStats& other) {
+        cycles += other.cycles;
+        instructions += other.instructions;
+        loadUseStalls += other.loadUseStalls;
+        macStalls += other.macStalls;
+        memStalls += other.memStalls;
+        fetchStalls += other.fetchStalls;
+        flushedInstructions += other.flushedInstructions;
+        controlTransfers += other.controlTransfers;
+        takenTransfers += other.takenTransfers;
+        mispredictions += other.mispredictions;
+        conditionalBranches += other.conditionalBranches;
+        conditionalMispredictions += other.conditionalMispredictions;
+        threeReadIssues += other.threeReadIssues;
+        pairedIssues += other.pairedIssues;
+        sleepCycles += other.sleepCycles;
+        activity.add(other.activity);
+    }
+
+    double mispredictionRate() const {
+        return conditionalBranches > 0 ? static_cast<double>(conditionalMispredictions) / conditionalBranches : 0.0;
+    }
+
+    double ipc() const {
+        return cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0;
+    }
+};
+
+class Pipeline {
+public:
+    enum Stage { IF = 0, ID, EX, MEM, WB, STAGE_COUNT };
+
+private:
+    struct Slot {
+        bool valid;
+        bool stalled;      // held in this stage this cycle (for the trace)
+        uint32_t pc;
+        Instruction in;
+        int remaining;     // cycles left in the current stage
+        uint32_t address;  // effective address of a load or store
+        uint32_t nextPc;   // where fetch went after this instruction
+        bool taken;        // replay: the recorded branch outcome
+        bool paired;       // a second-lane instruction travels with this one
+        uint32_t history;  // predictor history the branch was predicted with
+    };
+
+    Machine& machine;
+    PipelineConfig config;
+    Slot stages[STAGE_COUNT];
+    uint32_t fetchPc;
+    bool fetching;
+    bool redirectPending;
+    uint32_t redirectPc;
+    uint32_t loopStart;     // fetch's copy of the hardware loop registers
+    uint32_t loopEnd;
+    uint32_t loopCount;
+    bool loopBuffered;      // the body is in the loop buffer
+    bool done;
+    StepSource* source;     // replay() only
+    bool traceBlocked;      // replay: fetching the wrong path of a branch
+    std::vector<std::string>* trace;
+    uint64_t traceRemaining;
+
+    static Slot bubble() {
+        Slot slot;
+        slot.valid = false;
+        slot.stalled = false;
+        slot.pc = 0;
+        slot.remaining = 0;
+        slot.address = 0;
+        slot.nextPc = 0;
+        slot.taken = false;
+        slot.paired = false;
+        return slot;
+    }
+
+    bool loadUseHazard(const Instruction& consumer) const {
+        const Slot& producer = stages[MEM];
+        return producer.valid && isLoad(producer.in.kind) && readsRegister(consumer, producer.in.rd);
+    }
+
+    // Executes the instruction entering EX in the functional model
+    void execute(Slot& slot) {
+        if(source != nullptr) {
+            issue(slot);
+            uint32_t nextPc = slot.taken ? slot.pc + 2 + slot.in.imm : slot.pc + 2;
+            resolve(slot, slot.taken, nextPc != slot.nextPc);
+            redirectPending = nextPc != slot.nextPc;
+            return;
+        }
+        machine.pc = slot.pc;
+        if(isMemoryAccess(slot.in.kind)) slot.address = machine.regs[slot.in.rs1] + slot.in.imm;
+        Machine::Status status = machine.run(1);
+        issue(slot);
+
+        if(status == Machine::HALTED || status == Machine::FAULT) {
+            // Nothing younger may execute; let the pipeline drain
+            squashFrontEnd();
+            fetching = false;
+            return;
+        }
+        if(status == Machine::SLEEPING) {
+            redirectPending = true;
+            redirectPc = machine.pc;
+            return;
+        }
+        if(slot.in.kind == K_LOOP) armLoop();
+
+        bool mispredicted = machine.pc != slot.nextPc;
+        // Falling out of the end of a loop body is not a taken branch
+        bool taken = machine.pc != slot.pc + 2 && !(machine.loopEnd == slot.pc + 2 && machine.pc == machine.loopStart);
+        resolve(slot, taken, mispredicted);
+        if(mispredicted) {
+            redirectPending = true;
+            redirectPc = machine.pc;
+        }
+    }
+
+    // Register port and unit activity of an instruction entering EX
+    void issue(Slot& slot) {
+        int reads = registerReads(slot.in);
+        stats.activity.counts[EVENT_REG_READ] += reads;
+        stats.activity.counts[EVENT_REG_WRITE] += registerWrites(slot.in);
+        if(reads == 3) stats.threeReadIssues++;
+        countUnitActivity(slot.in);
+        slot.remaining = slot.in.kind == K_MAC || slot.in.kind == K_VMAC ? config.macLatency : 1;
+    }
+
+    // Control-transfer statistics and predictor training
+    void resolve(const Slot& slot, bool taken, bool mispredicted) {
+        if(!isControlTransfer(slot.in.kind)) return;
+        stats.controlTransfers++;
+        if(taken) stats.takenTransfers++;
+        if(isConditionalBranch(slot.in.kind)) {
+            stats.conditionalBranches++;
+            if(mispredicted) stats.conditionalMispredictions++;
+            if(config.predictor != nullptr) config.predictor->update(slot.pc, slot.pc + 2 + slot.in.imm, taken, slot.history);
+        }
+        if(mispredicted) stats.mispredictions++;
+    }
+
+    // LOOP just executed: copy the loop registers to fetch. Only the
+    // instruction in IF was fetched after it, so if that is the whole
+    // body fetch has just passed the end and goes back now.
+    void armLoop() {
+        syncLoop();
+        loopBuffered = false;
+        if(stages[IF].valid && stages[IF].nextPc == loopEnd) {
+            followLoop(fetchPc);
+            stages[IF].nextPc = fetchPc;
+        }
+    }
+
+    void syncLoop() {
+        if(machine.loopStart != loopStart) loopBuffered = false;
+        loopStart = machine.loopStart;
+        loopEnd = machine.loopEnd;
+        loopCount = machine.loopCount;
+    }
+
+    // Fetch's version of Machine::endOfLoopBody; the first time round the
+    // buffer fills
+    void followLoop(uint32_t& pc) {
+        if(pc != loopEnd) return;
+        if(--loopCount == 0) {
+            loopEnd = Machine::NO_LOOP;
+        } else {
+            pc = loopStart;
+            loopBuffered = true;
+        }
+    }
+
+    void countUnitActivity(const Instruction& in) {
+        uint64_t* counts = stats.activity.counts;
+        switch(in.kind) {
+            case K_NOP: case K_SLEEPM: case K_HALT: case K_MACMODE: case K_ILLEGAL:
+                break;
+            case K_MAC: case K_MULI:
+                counts[EVENT_MAC]++;
+                break;
+            case K_VCMPEQ: case K_VXOR: case K_VPOPC: case K_VMAC: case K_VREDSUM:
+                counts[EVENT_VECTOR_LANE] += machine.vectorBytes / 4;
+                break;
+            default:
+                counts[EVENT_ALU]++;
+                if(isMemoryAccess(in.kind)) counts[EVENT_DMEM_WORD] += in.kind == K_VLD ? machine.vectorBytes / 4 : 1;
+        }
+    }
+
+    int memoryLatency(const Slot& slot) {
+        if(!isMemoryAccess(slot.in.kind)) return 1;
+        if(config.memory == nullptr) return config.memLatency;
+        if(slot.in.kind != K_VLD) return config.memory->data(slot.address, slot.in.kind == K_SW);
+        // A vector load fetches every line it spans; the misses overlap
+        int cycles = 0;
+        uint32_t line = config.memory->settings().l1d.lineBytes;
+        for(uint32_t offset = 0; offset < machine.vectorBytes; offset += line) {
+            cycles = std::max(cycles, config.memory->data(slot.address + offset, false));
+        }
+        return cycles;
+    }
+
+    bool predictTaken(Slot& slot) {
+        if(config.predictor == nullptr) return false;
+        if(slot.in.kind == K_JAL) return config.predictor->followsJumps();
+        if(!isConditionalBranch(slot.in.kind)) return false;
+        slot.history = config.predictor->history();
+        return config.predictor->predict(slot.pc, slot.pc + 2 + slot.in.imm);
+    }
+
+    // Replay fetch: the next recorded instruction, or a NOP on the predicted
+    // path while a mispredicted branch is on its way to EX
+    void fetchStep() {
+        TraceStep step;
+        if(traceBlocked) {
+            step.pc = fetchPc;
+            step.in = Instruction{K_NOP, 0, 0, 0, 0};
+            step.address = 0;
+            step.taken = false;
+        } else if(!source->next(step)) {
+            fetching = false;
+            return;
+        }
+        Slot& slot = stages[IF];
+        slot.valid = true;
+        slot.pc = step.pc;
+        slot.in = step.in;
+        slot.address = step.address;
+        slot.taken = step.taken;
+        slot.remaining = config.memory != nullptr ? config.memory->fetch(step.pc) : 1;
+        stats.activity.counts[EVENT_FETCH]++;
+        bool predicted = predictTaken(slot);
+        fetchPc = predicted ? step.pc + 2 + step.in.imm : step.pc + 2;
+        slot.nextPc = fetchPc;
+        if(!traceBlocked && predicted != step.taken) traceBlocked = true;
+    }
+
+    // The second lane takes an instruction that needs only the ALU, does not
+    // read or write the first one's destinations (VLD also writes its
+    // post-incremented base) and is on the path the first one actually took
+    bool canPair(const Slot& first, const Slot& second) const {
+        if(!second.valid || second.remaining > 1 || redirectPending || !fetching) return false;
+        if(first.in.kind == K_LOOP || first.in.kind == K_SLEEPM || first.in.kind == K_MACMODE) return false;
+        switch(second.in.kind) {
+            case K_ADD: case K_SUB: case K_AND: case K_OR: case K_ADDI: case K_XORI: case K_BCNT: case K_NOP:
+                break;
+            default:
+                return false;
+        }
+        if(readsRegister(second.in, first.in.rd) || (first.in.rd != 0 && second.in.rd == first.in.rd)) return false;
+        if(first.in.kind == K_VLD && (readsRegister(second.in, first.in.rs1) || second.in.rd == first.in.rs1)) {
+            return false;
+        }
+        return !loadUseHazard(second.in);
+    }
+
+    void fetchNext() {
+        if(source != nullptr) {
+            fetchStep();
+            return;
+        }
+        Slot& slot = stages[IF];
+        slot.valid = true;
+        slot.pc = fetchPc;
+        slot.in = fetchPc < Machine::MEMORY_BYTES ? decode(machine.readHalf(fetchPc)) : decode(0x8000);
+        if(loopBuffered && loopEnd != Machine::NO_LOOP && fetchPc >= loopStart && fetchPc < loopEnd) {
+            slot.remaining = 1;
+            stats.activity.counts[EVENT_LOOP_BUFFER]++;
+        } else {
+            slot.remaining = config.memory != nullptr ? config.memory->fetch(fetchPc) : 1;
+            stats.activity.counts[EVENT_FETCH]++;
+        }
+        fetchPc = predictTaken(slot) ? fetchPc + 2 + slot.in.imm : fetchPc + 2;
+        followLoop(fetchPc);
+        slot.nextPc = fetchPc;
+    }
+
+    bool empty() const {
+        for(const auto& slot : stages) {
+            if(slot.valid) return false;
+        }
+        return true;
+    }
+
+    void squashFrontEnd() {
+        for(int stage = IF; stage <= ID; stage++) {
+            if(stages[stage].valid) stats.flushedInstructions++;
+            stages[stage] = bubble();
+        }
+    }
+
+    void recordTrace() {
+        if(trace == nullptr || traceRemaining == 0) return;
+        traceRemaining--;
+        static const char* stageNames[STAGE_COUNT] = {"IF", "ID", "EX", "MEM", "WB"};
+        char line[160];
+        int length = std::snprintf(line, sizeof(line), "%6llu |", static_cast<unsigned long long>(stats.cycles));
+        for(int stage = IF; stage < STAGE_COUNT; stage++) {
+            const Slot& slot = stages[stage];
+            char cell[24];
+            if(slot.valid) {
+                std::snprintf(cell, sizeof(cell), "%s%s", kindName(slot.in.kind), slot.stalled ? "*" : "");
+            } else {
+                std::snprintf(cell, sizeof(cell), "--");
+            }
+            length += std::snprintf(line + length, sizeof(line) - length, " %s %-10s|", stageNames[stage], cell);
+        }
+        trace->push_back(line);
+    }
+
+public:
+    PipelineStats stats;
+
+    Pipeline(Machine& target, const PipelineConfig& pipelineConfig)
+        : machine(target), config(pipelineConfig), source(nullptr), traceBlocked(false),
+          trace(nullptr), traceRemaining(0) {
+        reset(0);
+    }
+
+    // Attaches a cache hierarchy, or detaches it with nullptr
+    void setMemory(MemoryHierarchy* memory) {
+        config.memory = memory;
+    }
+
+    // Attaches a branch predictor, or goes back to not-taken with nullptr
+    void setPredictor(BranchPredictor* predictor) {
+        config.predictor = predictor;
+    }
+
+    // Starts an empty pipeline fetching at pc; statistics are kept
+    void reset(uint32_t pc) {
+        for(auto& slot : stages) slot = bubble();
+        fetchPc = pc;
+        fetching = true;
+        redirectPending = false;
+        redirectPc = 0;
+        loopBuffered = false;
+        loopStart = 0;
+        syncLoop();
+        done = false;
+    }
+
+    // Appends one line per cycle, "*" marking a held instruction, for the
+    // first maxCycles cycles; pass nullptr to stop tracing
+    void enableTrace(std::vector<std::string>* lines, uint64_t maxCycles) {
+        trace = lines;
+        traceRemaining = maxCycles;
+    }
+
+    // Advances one clock; returns false once the power-off instruction has
+    // retired or the functional model faulted
+    bool cycle() {
+        if(done) return false;
+        if(asleep()) {
+            sleep(1);
+            return true;
+        }
+        stats.cycles++;
+        for(auto& slot : stages) slot.stalled = false;
+        bool paired = false;
+
+        if(redirectPending) {
+            squashFrontEnd();
+            if(source != nullptr) {
+                traceBlocked = false;
+            } else {
+                fetchPc = redirectPc;
+                syncLoop();
+            }
+            redirectPending = false;
+        }
+
+        // WB: retire
+        if(stages[WB].valid) {
+            stats.instructions += stages[WB].paired ? 2 : 1;
+            if(stages[WB].in.kind == K_HALT || stages[WB].in.kind == K_ILLEGAL) done = true;
+        }
+        stages[WB] = bubble();
+
+        // MEM -> WB
+        if(stages[MEM].valid) {
+            if(stages[MEM].remaining > 1) {
+                stages[MEM].remaining--;
+                stages[MEM].stalled = true;
+                stats.memStalls++;
+            } else {
+                stages[WB] = stages[MEM];
+                stages[MEM] = bubble();
+            }
+        }
+
+        // EX -> MEM
+        if(stages[EX].valid) {
+            if(stages[EX].remaining > 1) {
+                stages[EX].remaining--;
+                stages[EX].stalled = true;
+                if(stages[EX].in.kind == K_MAC || stages[EX].in.kind == K_VMAC) stats.macStalls++;
+            } else if(!stages[MEM].valid) {
+                stages[MEM] = stages[EX];
+                stages[MEM].remaining = memoryLatency(stages[MEM]);
+                stages[EX] = bubble();
+            } else {
+                stages[EX].stalled = true;
+            }
+        }
+
+        // ID -> EX
+        if(stages[ID].valid) {
+            if(stages[EX].valid) {
+                stages[ID].stalled = true;
+            } else if(loadUseHazard(stages[ID].in)) {
+                // Waiting on a miss is already a memory stall
+                stages[ID].stalled = true;
+                if(!stages[MEM].stalled) stats.loadUseStalls++;
+            } else {
+                stages[EX] = stages[ID];
+                stages[ID] = bubble();
+                execute(stages[EX]);
+                if(config.issueWidth > 1 && canPair(stages[EX], stages[IF])) {
+                    execute(stages[IF]);
+                    stages[IF] = bubble();
+                    stages[EX].paired = true;
+                    stats.pairedIssues++;
+                    paired = true;
+                }
+            }
+        }
+
+        // IF -> ID, then fetch
+        if(stages[IF].valid) {
+            if(stages[IF].remaining > 1) {
+                stages[IF].remaining--;
+                stages[IF].stalled = true;
+                stats.fetchStalls++;
+            } else if(stages[ID].valid) {
+                stages[IF].stalled = true;
+            } else {
+                stages[ID] = stages[IF];
+                stages[IF] = bubble();
+            }
+        }
+        if(!stages[IF].valid && fetching && machine.status != Machine::SLEEPING) fetchNext();
+        // The pair just issued emptied IF and ID: the other half of the
+        // 32-bit fetch moves up and the next pair starts
+        if(paired && !stages[ID].valid && stages[IF].valid && stages[IF].remaining <= 1 && fetching) {
+            stages[ID] = stages[IF];
+            stages[IF] = bubble();
+            fetchNext();
+        }
+
+        // A stage with a held or no instruction has its clock gated
+        for(const auto& slot : stages) {
+            stats.activity.counts[slot.valid && !slot.stalled ? EVENT_STAGE_ACTIVE : EVENT_STAGE_GATED]++;
+        }
+        stats.activity.counts[EVENT_CLOCK]++;
+        stats.activity.counts[EVENT_LEAKAGE]++;
+        recordTrace();
+        if(source != nullptr ? !fetching && empty() : machine.status == Machine::FAULT) done = true;
+        return !done;
+    }
+
+    // Asleep in SLEEPM with nothing left in flight
+    bool asleep() const {
+        return machine.status == Machine::SLEEPING && !redirectPending && empty();
+    }
+
+    // Counts cycles of sleep at once, for a host that skips ahead to the
+    // next interrupt while asleep() holds
+    void sleep(uint64_t cycles) {
+        stats.cycles += cycles;
+        stats.sleepCycles += cycles;
+        stats.activity.counts[sleepEvent(machine.lastSleepMode)] += cycles;
+    }
+
+    // Runs from machine.pc until power-off; returns the functional status
+    Machine::Status run(uint64_t maxCycles) {
+        reset(machine.pc);
+        for(uint64_t i = 0; i < maxCycles && cycle(); i++) {
+        }
+        return done ? machine.status : Machine::STEP_LIMIT;
+    }
+
+    // Times the instructions from steps instead of running the Machine;
+    // returns false if maxCycles ran out first
+    bool replay(StepSource& steps, uint64_t maxCycles) {
+        reset(0);
+        source = &steps;
+        traceBlocked = false;
+        loopEnd = Machine::NO_LOOP;
+        for(uint64_t i = 0; i < maxCycles && cycle(); i++) {
+        }
+        source = nullptr;
+        return done;
+    }
+};
+
+} // namespace isa
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef POWER_MODEL_H
+#define POWER_MODEL_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+// Activity-based energy model of the core. The pipeline model counts
+// per-cycle events; energy is those counts weighted by per-event
+// coefficients. energy_model.h covers the phone-level costs (radios,
+// feature extraction); this covers what the custom core itself burns.
+//
+// Coefficients are in picojoules and default to ballpark figures for a
+// small 32-bit core in 28nm at 200 MHz; replace them with synthesis or
+// silicon numbers via PowerModel::setCoefficient().
+//
+// A stage that holds (stalled) or is empty has its clock enable low and
+// is charged as gated. SLEEPM modes 0-7 are light sleep (clock gated,
+// state kept) and 8-14 deep sleep (power gated, retention only).
+namespace isa {
+
+enum CoreEvent {
+    EVENT_CLOCK = 0,        // clock tree, per cycle
+    EVENT_LEAKAGE,          // static power of the awake core, per cycle
+    EVENT_STAGE_ACTIVE,     // one pipeline stage clocked, per cycle
+    EVENT_STAGE_GATED,      // one stage clock-gated, per cycle
+    EVENT_FETCH,            // one 16-bit instruction memory read
+    EVENT_LOOP_BUFFER,      // one instruction read from the loop buffer
+    EVENT_REG_READ,         // one register file read port use
+    EVENT_REG_WRITE,        // one register file write
+    EVENT_ALU,              // one ALU / branch / address operation
+    EVENT_MAC,              // one 32-bit multiply(-accumulate)
+    EVENT_VECTOR_LANE,      // one 32-bit lane of a SIMD operation
+    EVENT_DMEM_WORD,        // one 32-bit data memory access
+    EVENT_SLEEP_LIGHT,      // one cycle in light sleep
+    EVENT_SLEEP_DEEP,       // one cycle in deep sleep
+    CORE_EVENT_COUNT
+};
+
+inline const char* coreEventName(int event) {
+    static const char* names[CORE_EVENT_COUNT] = {
+        "Clock tree", "Leakage", "Pipeline latches", "Gated stages", "Fetch", "Loop buffer", "RF read", "RF write",
+        "ALU", "MAC", "Vector lanes", "Data memory", "Light sleep", "Deep sleep"
+    };
+    return names[event];
+}
+
+inline CoreEvent sleepEvent(int mode) {
+    return mode < 8 ? EVENT_SLEEP_LIGHT : EVENT_SLEEP_DEEP;
+}
+
+struct Activity {
+    uint64_t counts[CORE_EVENT_COUNT];
+
+    Activity() { clear(); }
+
+    void clear() {
+        std::memset(counts, 0, sizeof(counts));
+    }
+
+    void add(const Activity& other) {
+        for(int event = 0; event < CORE_EVENT_COUNT; event++) counts[event] += other.counts[event];
+    }
+};
+
+class PowerModel {
+private:
+    double coefficients[CORE_EVENT_COUNT];
+
+public:
+    PowerModel() {
+        static const double defaults[CORE_EVENT_COUNT] = {
+            1.0,    // EVENT_CLOCK
+            0.5,    // EVENT_LEAKAGE: ~0.1mW at 200 MHz
+            0.4,    // EVENT_STAGE_ACTIVE
+            0.05,   // EVENT_STAGE_GATED
+            2.0,    // EVENT_FETCH: 16-bit SRAM read
+            0.2,    // EVENT_LOOP_BUFFER: 8 x 16-bit latch array
+            0.6,    // EVENT_REG_READ
+            0.8,    // EVENT_REG_WRITE
+            1.0,    // EVENT_ALU
+            4.0,    // EVENT_MAC
+            3.0,    // EVENT_VECTOR_LANE
+            5.0,    // EVENT_DMEM_WORD: 32-bit SRAM access
+            0.3,    // EVENT_SLEEP_LIGHT: leakage plus the ungated clock root
+            0.02    // EVENT_SLEEP_DEEP: retention only
+        };
+        std::memcpy(coefficients, defaults, sizeof(coefficients));
+    }
+
+    void setCoefficient(CoreEvent event, double picojoules) {
+        coefficients[event] = picojoules;
+    }
+
+    // Scales the coefficients for a larger or smaller core: dynamic ones by
+    // dynamic, leakage and the sleep states by leakage
+    void scale(double dynamic, double leakage) {
+        for(int event = 0; event < CORE_EVENT_COUNT; event++) {
+            bool isStatic = event == EVENT_LEAKAGE || event == EVENT_SLEEP_LIGHT || event == EVENT_SLEEP_DEEP;
+            coefficients[event] *= isStatic ? leakage : dynamic;
+        }
+    }
+
+    double picojoules(const Activity& activity, int event) const {
+        return activity.counts[event] * coefficients[event];
+    }
+
+    double totalPicojoules(const Activity& activity) const {
+        double total = 0.0;
+        for(int event = 0; event < CORE_EVENT_COUNT; event++) total += picojoules(activity, event);
+        return total;
+    }
+
+    // One line per unit that used energy, largest share first, divided
+    // over events (frames, calls)
+    std::string breakdown(const Activity& activity, uint64_t events) const {
+        std::vector<int> used;
+        for(int event = 0; event < CORE_EVENT_COUNT; event++) {
+            if(activity.counts[event] > 0 && coefficients[event] > 0.0) used.push_back(event);
+        }
+        std::sort(used.begin(), used.end(), [&](int a, int b) {
+            return picojoules(activity, a) > picojoules(activity, b);
+        });
+
+        std::string text;
+        double total = totalPicojoules(activity);
+        char line[128];
+        for(int event : used) {
+            std::snprintf(line, sizeof(line), "   • %-16s %12.1f pJ (%4.1f%%)\n", coreEventName(event),
+                          picojoules(activity, event) / (events > 0 ? events : 1),
+                          total > 0.0 ? 100.0 * picojoules(activity, event) / total : 0.0);
+            text += line;
+        }
+        return text;
+    }
+};
+
+} // namespace isa
+
+#endif
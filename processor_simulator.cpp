@@ -0,0 +1,2111 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include "isa.h"
+#include "iss.h"
+#include "pipeline.h"
+#include "cache.h"
+#include "branch_predictor.h"
+#include "power_model.h"
+#include "assembler.h"
+#include "jit.h"
+#include "op_trace.h"
+#include "trace_frontend.h"
+#include "multicore.h"
+#include "peripherals.h"
+#include "simpoint.h"
+
+class ProcessorSim {
+private:
+    struct Kernel {
+        const char* name;
+        const char* prototype;
+        uint32_t entry;
+        uint32_t bytes;
+    };
+    
+    // Totals over every call of one kernel
+    struct KernelStats {
+        uint64_t calls;
+        uint64_t instructions;
+        uint64_t kindCounts[isa::K_COUNT];
+        double seconds;
+        int mismatches;
+        isa::PipelineStats pipeline;
+        
+        KernelStats() : calls(0), instructions(0), seconds(0.0), mismatches(0) {
+            std::memset(kindCounts, 0, sizeof(kindCounts));
+        }
+    };
+    
+    enum Engine { FUNCTIONAL, PIPELINE, JIT };
+    
+    // Release-to-completion latency of one workload's jobs
+    struct JobLatency {
+        uint64_t jobs;
+        uint64_t totalCycles;
+        uint64_t worstCycles;
+        
+        JobLatency() : jobs(0), totalCycles(0), worstCycles(0) {}
+        
+        void add(uint64_t cycles) {
+            jobs++;
+            totalCycles += cycles;
+            worstCycles = std::max(worstCycles, cycles);
+        }
+        
+        double meanMicroseconds() const {
+            return jobs > 0 ? 1e6 * totalCycles / jobs / CLOCK_HZ : 0.0;
+        }
+        
+        double worstMicroseconds() const {
+            return 1e6 * worstCycles / CLOCK_HZ;
+        }
+    };
+    
+    // A job on the multicore model: a chain of kernel calls, each started
+    // when the previous one halts
+    struct Job {
+        bool voice;
+        uint64_t release;
+        int step;
+        int index;              // frame or scan
+        uint32_t posted;        // the other mailbox's sequence when the read started
+    };
+    
+    struct MulticoreRun {
+        JobLatency voice;
+        JobLatency decisions;
+        isa::BusStats bus;
+        uint64_t activeCycles;  // cycles with at least one core running
+        int mismatches;
+        
+        MulticoreRun() : activeCycles(0), mismatches(0) {}
+    };
+    
+    // Memory map: the linked kernel library from 0, data from 0x4000,
+    // stack at the top. Kernels return to powerOff in runtime.s.
+    static const uint32_t DATA_BASE = 0x4000;
+    static const int KEYWORD_MODELS = 3;
+    static const int FEATURE_LENGTH = 256;
+    static const int TEMPLATE_WORDS = 64;       // 2048-bit binary templates
+    static const uint32_t USER_TABLE = DATA_BASE + 0x1000;
+    static const int USER_COUNT = 512;
+    static const uint32_t USER_RECORD_BYTES = 32;
+    static constexpr double CLOCK_HZ = 200e6;      // low end of the spec's 200-500 MHz
+    static constexpr double DECISION_BUDGET = 5e-3;
+    static constexpr double FRAME_SECONDS = 0.064;  // one 1024-sample frame at 16kHz
+    // Multicore jobs: scans and trusted devices past the user table, where
+    // auth requests also keep their templates
+    static const uint32_t SCAN_ADDRESS = DATA_BASE + 0x5000;
+    static const uint32_t TRUSTED_ADDRESS = DATA_BASE + 0x5100;
+    static const uint32_t ENROLLED_ADDRESS = DATA_BASE + 0x5200;
+    static const uint32_t PROBE_ADDRESS = DATA_BASE + 0x5300;
+    static const uint32_t AUTH_NEARBY_ADDRESS = DATA_BASE + 0x5400;
+    static const uint32_t MAILBOX_ADDRESS = DATA_BASE + 0x5800;   // voice mailbox; the connectivity one follows
+    static const int SCANS_PER_FRAME = 64;
+    static const int AUTHS_PER_WINDOW = 4;
+    // Interrupt-driven voice loop: the DMA control block and a ring of
+    // feature frames
+    static const uint32_t VOICE_CONTROL_ADDRESS = DATA_BASE + 0x5900;
+    static const uint32_t VOICE_RING_ADDRESS = DATA_BASE + 0x6000;
+    static const uint32_t VOICE_RING_SLOTS = 4;
+    // Sampled-simulation session: feature frames (over the voice ring's
+    // space) and the schedule of calls runSchedule walks
+    static const uint32_t SESSION_FRAME_ADDRESS = DATA_BASE + 0x6000;
+    static const int SESSION_FRAMES = 8;
+    static const uint32_t SESSION_SCHEDULE_ADDRESS = DATA_BASE + 0x8000;
+    static const uint32_t SCHEDULE_RECORD_BYTES = 32;
+    static const int FRAMES_PER_PASS = 64;
+    
+    // big.LITTLE study: task classes in priority order and placement policies
+    enum TaskClass { TASK_VOICE = 0, TASK_AUTH, TASK_SCAN, TASK_CLASSES };
+    enum Placement { PLACE_ALL_BIG = 0, PLACE_ALL_LITTLE, PLACE_BY_PROFILE, PLACE_GREEDY, PLACE_EDP_AWARE, PLACEMENTS };
+    static const int BIG = 0;
+    static const int LITTLE = 1;
+    
+    // A task on the big.LITTLE pair: one or two kernel calls that hold the
+    // core they were placed on until the last one returns
+    struct Task {
+        int taskClass;
+        int window;
+        int step;
+        uint64_t release;
+        uint64_t start;
+    };
+    
+    // Per task class and core: mean cycles a task holds the core and the
+    // core energy it takes
+    struct TaskProfile {
+        double cycles[TASK_CLASSES][2];
+        double nanojoules[TASK_CLASSES][2];
+    };
+    
+    struct BigLittleRun {
+        JobLatency latency[TASK_CLASSES];   // release to completion
+        JobLatency service[TASK_CLASSES];   // placement to completion
+        uint64_t placed[TASK_CLASSES][2];
+        isa::Activity activity[2];          // running, sleep included
+        uint64_t makespan;
+        int mismatches;
+        
+        BigLittleRun() : makespan(0), mismatches(0) {
+            for(auto& counts : placed) counts[BIG] = counts[LITTLE] = 0;
+        }
+    };
+    
+    isa::Machine machine;
+    isa::Pipeline pipeline;
+    isa::Jit jit;
+    Engine engine;
+    std::vector<Kernel> kernels;
+    uint32_t powerOffAddress;
+    isa::MemoryHierarchy* memory;   // attached to the pipeline during the cache study
+    
+public:
+    ProcessorSim()
+        : pipeline(machine, isa::PipelineConfig()), jit(machine), engine(FUNCTIONAL), powerOffAddress(0), memory(nullptr) {}
+    
+    // Assembles and links the kernel library from directory and loads it
+    // into simulated memory
+    bool loadKernels(const std::string& directory) {
+        std::cout << "Assembling kernel library from " << directory << "/ ..." << std::endl;
+        const char* sources[] = {
+            "runtime.s", "similarity.s", "match_keywords.s", "match_keywords_dot.s", "trusted_environment.s",
+            "trust_level.s", "hamming.s", "similarity_simd.s", "match_keywords_simd.s", "hamming_simd.s",
+            "similarity_loop.s", "match_keywords_loop.s", "mailbox.s", "voice_service.s",
+            "run_schedule.s"
+        };
+        isa::Assembler assembler;
+        for(const char* source : sources) assembler.addFile(directory + "/" + source);
+        isa::Image image;
+        if(!assembler.link(0, image)) {
+            for(const auto& message : assembler.errors()) std::cout << "❌ " << message << std::endl;
+            return false;
+        }
+        return installLibrary(image);
+    }
+    
+    // A library linked ahead of time by the assembler (-o image -m map)
+    bool loadImage(const std::string& imagePath, const std::string& mapPath) {
+        std::cout << "Loading kernel library " << imagePath << " (symbols from " << mapPath << ") ..." << std::endl;
+        isa::Image image;
+        std::string error;
+        if(!isa::readImage(imagePath, image, error) || !isa::readSymbolMap(mapPath, image, error)) {
+            std::cout << "❌ " << error << std::endl;
+            return false;
+        }
+        if(image.end() > isa::Machine::MEMORY_BYTES) {
+            std::cout << "❌ " << imagePath << " does not fit in the address space" << std::endl;
+            return false;
+        }
+        return installLibrary(image);
+    }
+    
+    // Loads the library into memory and finds every kernel's entry and size
+    bool installLibrary(isa::Image& image) {
+        machine.loadBytes(image.bytes, image.base);
+        
+        kernels = {
+            {"computeSimilarity", "voice", 0, 0},
+            {"isTrustedEnvironment", "biometric", 0, 0},
+            {"evaluateTrustLevel", "connectivity", 0, 0},
+            {"matchKeywords", "voice", 0, 0},
+            {"hammingDistance", "biometric", 0, 0},
+            {"computeSimilarityV", "voice", 0, 0},
+            {"matchKeywordsV", "voice", 0, 0},
+            {"hammingDistanceV", "biometric", 0, 0},
+            {"matchKeywordsDot4", "voice", 0, 0},
+            {"matchKeywordsDot2", "voice", 0, 0},
+            {"computeSimilarityLoop", "voice", 0, 0},
+            {"matchKeywordsLoop", "voice", 0, 0},
+            {"postEvent", "multicore", 0, 0},
+            {"readEvent", "multicore", 0, 0},
+            {"voiceService", "voice", 0, 0},
+            {"runSchedule", "sampling", 0, 0}
+        };
+        if(!image.symbols.count("powerOff")) {
+            std::cout << "❌ runtime.s does not define powerOff" << std::endl;
+            return false;
+        }
+        powerOffAddress = image.symbols["powerOff"];
+        for(auto& kernel : kernels) {
+            if(!image.symbols.count(kernel.name)) {
+                std::cout << "❌ kernel library does not define " << kernel.name << std::endl;
+                return false;
+            }
+            // A kernel runs up to the next global symbol
+            kernel.entry = image.symbols[kernel.name];
+            uint32_t end = image.end();
+            for(const auto& symbol : image.symbols) {
+                if(symbol.first.find(':') == std::string::npos && symbol.second > kernel.entry) {
+                    end = std::min(end, symbol.second);
+                }
+            }
+            kernel.bytes = end - kernel.entry;
+            char placement[32];
+            std::snprintf(placement, sizeof(placement), "%u bytes at 0x%04x", kernel.bytes, kernel.entry);
+            std::cout << "  - " << kernel.name << " (" << kernel.prototype << "): " << placement << std::endl;
+        }
+        return true;
+    }
+    
+    void testKernelSuite() {
+        std::cout << "\n=== Kernel Suite on the Functional ISS ===" << std::endl;
+        std::cout << "Running the assembled prototype kernels..." << std::endl;
+        
+        engine = FUNCTIONAL;
+        printKernelStats(kernels[0], runVoiceKernel(2000));
+        printKernelStats(kernels[1], runBiometricKernel(200000));
+        printKernelStats(kernels[2], runConnectivityKernel(200000));
+        printKernelStats(kernels[3], runKeywordKernel(2000));
+    }
+    
+    void testPipelineModel() {
+        std::cout << "\n=== 5-Stage Pipeline Model ===" << std::endl;
+        std::cout << "Forwarding on, predict not-taken, branches resolve in EX, MAC takes 2 cycles..." << std::endl;
+        
+        engine = PIPELINE;
+        printPipelineStats(kernels[0], runVoiceKernel(100));
+        printPipelineStats(kernels[1], runBiometricKernel(20000));
+        printPipelineStats(kernels[2], runConnectivityKernel(20000));
+        printPipelineStats(kernels[3], runKeywordKernel(100));
+        engine = FUNCTIONAL;
+    }
+    
+    void showCycleTrace() {
+        std::cout << "\n=== Pipeline Cycle Trace ===" << std::endl;
+        std::cout << "First 30 cycles of one call per kernel; * = held in stage" << std::endl;
+        
+        engine = PIPELINE;
+        for(int k = 0; k < 3; k++) {
+            std::vector<std::string> lines;
+            pipeline.enableTrace(&lines, 30);
+            if(k == 0) runVoiceKernel(1);
+            else if(k == 1) runBiometricKernel(1);
+            else runConnectivityKernel(1);
+            pipeline.enableTrace(nullptr, 0);
+            
+            std::cout << "\n--- " << kernels[k].name << " ---" << std::endl;
+            for(const auto& line : lines) std::cout << line << std::endl;
+        }
+        engine = FUNCTIONAL;
+    }
+    
+    void benchmarkJit() {
+        std::cout << "\n=== JIT Backend vs Interpreter ===" << std::endl;
+        if(!jit.available()) {
+            std::cout << "❌ No JIT backend on this host (needs x86-64 Linux/FreeBSD); interpreter only" << std::endl;
+            return;
+        }
+        std::cout << "Running matchKeywords over 4000 frames (256 s of audio) on each engine..." << std::endl;
+        
+        const int frames = 4000;
+        engine = FUNCTIONAL;
+        KernelStats interpreted = runKeywordKernel(frames);
+        engine = JIT;
+        uint64_t blocksBefore = jit.blocksTranslated;
+        KernelStats translated = runKeywordKernel(frames);
+        engine = FUNCTIONAL;
+        
+        double interpreterMips = interpreted.instructions / interpreted.seconds / 1e6;
+        double jitMips = translated.instructions / translated.seconds / 1e6;
+        double audioSeconds = frames * FRAME_SECONDS;
+        std::cout << "Interpreter: " << interpreterMips << " MIPS, "
+                  << audioSeconds / interpreted.seconds << "x real time" << std::endl;
+        std::cout << "JIT:         " << jitMips << " MIPS, "
+                  << audioSeconds / translated.seconds << "x real time" << std::endl;
+        std::cout << "🚀 Speedup: " << jitMips / interpreterMips << "x" << std::endl;
+        std::cout << "Blocks translated: " << jit.blocksTranslated - blocksBefore << ", chains patched: "
+                  << jit.chainsPatched << ", cache flushes: " << jit.cacheFlushes
+                  << ", interpreter exits: " << jit.interpreterExits << std::endl;
+        
+        bool sameWork = interpreted.instructions == translated.instructions &&
+                        std::equal(interpreted.kindCounts, interpreted.kindCounts + isa::K_COUNT, translated.kindCounts);
+        if(translated.mismatches == 0 && sameWork) {
+            std::cout << "✅ Same results, instruction counts and mix as the interpreter" << std::endl;
+        } else {
+            std::cout << "❌ JIT diverges: " << translated.mismatches << " wrong results, "
+                      << translated.instructions << " vs " << interpreted.instructions << " instructions" << std::endl;
+        }
+    }
+    
+    void runCacheStudy() {
+        std::cout << "\n=== Cache Hierarchy Study ===" << std::endl;
+        isa::HierarchyConfig baseline;
+        char setup[160];
+        std::snprintf(setup, sizeof(setup), "L1I %uB/%u-way, L1D %uB/%u-way, %uB lines, L2 %uB/%u-way (%d cycles), DRAM %d cycles",
+                      baseline.l1i.sizeBytes, baseline.l1i.associativity, baseline.l1d.sizeBytes,
+                      baseline.l1d.associativity, baseline.l1d.lineBytes, baseline.l2.sizeBytes,
+                      baseline.l2.associativity, baseline.l2.hitLatency, baseline.dramLatency);
+        std::cout << setup << std::endl;
+        
+        for(int k = 0; k < 4; k++) {
+            isa::MemoryHierarchy hierarchy(baseline);
+            KernelStats cached = runWithHierarchy(k, &hierarchy);
+            KernelStats ideal = runWithHierarchy(k, nullptr);
+            char line[160];
+            std::cout << "\n--- " << kernels[k].name << " (" << kernels[k].prototype << ") ---" << std::endl;
+            std::snprintf(line, sizeof(line), "Miss rate: L1I %.2f%%, L1D %.2f%%, L2 %.2f%% (local); DRAM reads %llu, writes %llu",
+                          100.0 * hierarchy.l1i.stats.missRate(), 100.0 * hierarchy.l1d.stats.missRate(),
+                          100.0 * hierarchy.l2.stats.missRate(), static_cast<unsigned long long>(hierarchy.dramReads),
+                          static_cast<unsigned long long>(hierarchy.dramWrites));
+            std::cout << line << std::endl;
+            std::snprintf(line, sizeof(line), "AMAT: fetch %.2f, data %.2f cycles; IPC %.3f vs %.3f with ideal memory",
+                          hierarchy.instructionAmat(), hierarchy.dataAmat(), cached.pipeline.ipc(), ideal.pipeline.ipc());
+            std::cout << line << std::endl;
+            if(cached.mismatches != 0) {
+                std::cout << "❌ " << cached.mismatches << " results differ from the C++ reference" << std::endl;
+            }
+        }
+        
+        // SRAM size against performance for the streaming and the table-lookup workload
+        const uint32_t sizes[] = {512, 1024, 2048, 4096, 8192};
+        for(int k = 0; k < 2; k++) {
+            std::cout << "\n--- L1D size sweep: " << kernels[k].name << " (" << kernels[k].prototype << ") ---" << std::endl;
+            std::cout << "  L1D    L2   SRAM    L1D miss  AMAT(D)  IPC" << std::endl;
+            double bestIpc = 0.0;
+            std::vector<std::pair<uint32_t, double>> results;
+            std::vector<std::string> labels;
+            for(int useL2 = 0; useL2 < 2; useL2++) {
+                for(uint32_t size : sizes) {
+                    isa::HierarchyConfig config;
+                    config.l1d.sizeBytes = size;
+                    config.useL2 = useL2 != 0;
+                    isa::MemoryHierarchy hierarchy(config);
+                    KernelStats stats = runWithHierarchy(k, &hierarchy);
+                    char line[96];
+                    std::snprintf(line, sizeof(line), "  %4uB  %-4s %6uB  %6.2f%%   %6.2f  %.3f", size, useL2 ? "on" : "off",
+                                  hierarchy.sramBytes(), 100.0 * hierarchy.l1d.stats.missRate(), hierarchy.dataAmat(),
+                                  stats.pipeline.ipc());
+                    std::cout << line << std::endl;
+                    bestIpc = std::max(bestIpc, stats.pipeline.ipc());
+                    results.push_back(std::make_pair(hierarchy.sramBytes(), stats.pipeline.ipc()));
+                    char label[48];
+                    std::snprintf(label, sizeof(label), "%uB L1D, L2 %s", size, useL2 ? "on" : "off");
+                    labels.push_back(label);
+                }
+            }
+            size_t choice = 0;
+            for(size_t i = 0; i < results.size(); i++) {
+                bool good = results[i].second >= 0.95 * bestIpc;
+                if(good && (results[choice].second < 0.95 * bestIpc || results[i].first < results[choice].first)) choice = i;
+            }
+            std::cout << "📐 Cheapest within 5% of the best IPC: " << labels[choice] << " ("
+                      << results[choice].first << " bytes of SRAM)" << std::endl;
+        }
+        
+        std::cout << "\n--- 1KB L1D organisation: " << kernels[1].name << " (" << kernels[1].prototype << ") ---" << std::endl;
+        const isa::Replacement policies[] = {isa::REPLACE_LRU, isa::REPLACE_FIFO, isa::REPLACE_RANDOM};
+        for(uint32_t ways : {1u, 2u, 4u}) {
+            std::cout << " " << ways << "-way:";
+            for(isa::Replacement policy : policies) {
+                if(ways == 1 && policy != isa::REPLACE_LRU) continue;
+                isa::HierarchyConfig config;
+                config.l1d = isa::CacheConfig(1024, ways, 16, policy, 1);
+                isa::MemoryHierarchy hierarchy(config);
+                runWithHierarchy(1, &hierarchy);
+                char cell[48];
+                std::snprintf(cell, sizeof(cell), " %s %.2f%% miss", ways == 1 ? "direct" : isa::replacementName(policy),
+                              100.0 * hierarchy.l1d.stats.missRate());
+                std::cout << cell;
+            }
+            std::cout << std::endl;
+        }
+    }
+    
+    void exploreBranchPredictors() {
+        std::cout << "\n=== Branch Predictor Exploration ===" << std::endl;
+        std::cout << "Fetch-stage direction predictors; a misprediction costs the 2-cycle IF/ID flush" << std::endl;
+        
+        for(int k : {2, 1}) {
+            isa::StaticNotTaken staticNotTaken;
+            isa::Btfn btfn;
+            isa::Bimodal bimodal(256);
+            isa::Gshare gshare(256, 8);
+            isa::TageLite tage(256, 64);
+            isa::BranchPredictor* predictors[] = {&staticNotTaken, &btfn, &bimodal, &gshare, &tage};
+            
+            std::cout << "\n--- " << kernels[k].name << " (" << kernels[k].prototype << ") ---" << std::endl;
+            std::cout << "  Predictor          Storage  Mispredict   CPI   vs static  Call @200MHz" << std::endl;
+            double baseCpi = 0.0;
+            double bestCpi = 1e9;
+            std::vector<double> cpis;
+            std::vector<double> callSeconds;
+            for(isa::BranchPredictor* predictor : predictors) {
+                KernelStats stats = runWithPredictor(k, predictor);
+                const isa::PipelineStats& p = stats.pipeline;
+                double cpi = 1.0 / p.ipc();
+                if(predictor == predictors[0]) baseCpi = cpi;
+                bestCpi = std::min(bestCpi, cpi);
+                cpis.push_back(cpi);
+                callSeconds.push_back(static_cast<double>(p.cycles) / stats.calls / CLOCK_HZ);
+                
+                char line[128];
+                std::snprintf(line, sizeof(line), "  %-17s %6u b  %7.2f%%   %.3f   %+6.1f%%   %7.3f us",
+                              predictor->name(), predictor->storageBits(), 100.0 * p.mispredictionRate(), cpi,
+                              100.0 * (cpi - baseCpi) / baseCpi, callSeconds.back() * 1e6);
+                std::cout << line << std::endl;
+                if(stats.mismatches != 0) {
+                    std::cout << "❌ " << stats.mismatches << " results differ from the C++ reference" << std::endl;
+                }
+            }
+            
+            // Predictors are listed cheapest first
+            int meetsBudget = -1;
+            int nearBest = -1;
+            for(int i = 0; i < 5; i++) {
+                if(meetsBudget < 0 && callSeconds[i] < DECISION_BUDGET) meetsBudget = i;
+                if(nearBest < 0 && cpis[i] <= 1.02 * bestCpi) nearBest = i;
+            }
+            if(meetsBudget >= 0) {
+                std::cout << "📐 Cheapest meeting the 5 ms decision target: " << predictors[meetsBudget]->name()
+                          << " (" << callSeconds[meetsBudget] * 1e6 << " us per call)" << std::endl;
+            } else {
+                std::cout << "❌ No predictor meets the 5 ms decision target" << std::endl;
+            }
+            std::cout << "📐 Cheapest within 2% of the best CPI: " << predictors[nearBest]->name() << " ("
+                      << predictors[nearBest]->storageBits() << " bits)" << std::endl;
+        }
+    }
+    
+    void runSimdStudy() {
+        std::cout << "\n=== Packed-SIMD Width Study ===" << std::endl;
+        std::cout << "Pipeline model; VMAC takes the MAC latency, VLD one MEM cycle at any width" << std::endl;
+        
+        const uint32_t widths[] = {4, 8, 16, 32};
+        for(int study = 0; study < 2; study++) {
+            int scalar = study == 0 ? 3 : 4;
+            int vector = study == 0 ? 6 : 7;
+            std::cout << "\n--- " << kernels[scalar].name << " vs " << kernels[vector].name << " ("
+                      << kernels[scalar].prototype << ") ---" << std::endl;
+            std::cout << "  Width    Instr/call  Cycles/call  Speedup  Area kGE" << std::endl;
+            
+            double baseCycles = 0.0;
+            for(int row = 0; row < 5; row++) {
+                uint32_t width = row == 0 ? 0 : widths[row - 1];
+                machine.vectorBytes = row == 0 ? 16 : width;
+                int k = row == 0 ? scalar : vector;
+                engine = PIPELINE;
+                KernelStats stats = study == 0 ? runKeywordKernel(50, k) : runHammingKernel(500, k);
+                engine = FUNCTIONAL;
+                
+                double cycles = static_cast<double>(stats.pipeline.cycles) / stats.calls;
+                if(row == 0) baseCycles = cycles;
+                char label[16];
+                std::snprintf(label, sizeof(label), row == 0 ? "scalar" : "%uB", width);
+                char line[96];
+                std::snprintf(line, sizeof(line), "  %-7s %10.1f  %11.1f  %6.2fx  %7.1f", label,
+                              static_cast<double>(stats.instructions) / stats.calls, cycles, baseCycles / cycles,
+                              row == 0 ? 0.0 : simdAreaKge(width));
+                std::cout << line << std::endl;
+                if(stats.mismatches != 0) {
+                    std::cout << "❌ " << stats.mismatches << " results differ from the C++ reference" << std::endl;
+                }
+            }
+        }
+        machine.vectorBytes = 16;
+    }
+    
+    void evaluateDotProduct() {
+        std::cout << "\n=== Fused Dot-Product Proposal (DOT4.B / DOT2.H) ===" << std::endl;
+        std::cout << "matchKeywords over 200 frames on the pipeline model; the DOT modes keep the 2-cycle MAC" << std::endl;
+        std::cout << "  Instruction  Instr/frame  Cycles/frame  Speedup  RF reads/frame  Reads/cycle  Writes/cycle  3-read issues"
+                  << std::endl;
+        
+        const char* names[] = {"MAC", "DOT2.H", "DOT4.B"};
+        const int variants[][2] = {{3, 1}, {9, 2}, {8, 4}};  // kernel, elements per word
+        double baseCycles = 0.0;
+        for(int v = 0; v < 3; v++) {
+            engine = PIPELINE;
+            KernelStats stats = runKeywordKernel(200, variants[v][0], variants[v][1]);
+            engine = FUNCTIONAL;
+            const isa::PipelineStats& p = stats.pipeline;
+            double cycles = static_cast<double>(p.cycles) / stats.calls;
+            if(v == 0) baseCycles = cycles;
+            
+            char line[160];
+            std::snprintf(line, sizeof(line), "  %-11s %11.1f  %12.1f  %6.2fx  %14.1f  %11.2f  %12.2f  %13.1f", names[v],
+                          static_cast<double>(stats.instructions) / stats.calls, cycles, baseCycles / cycles,
+                          static_cast<double>(p.activity.counts[isa::EVENT_REG_READ]) / stats.calls,
+                          static_cast<double>(p.activity.counts[isa::EVENT_REG_READ]) / p.cycles,
+                          static_cast<double>(p.activity.counts[isa::EVENT_REG_WRITE]) / p.cycles,
+                          static_cast<double>(p.threeReadIssues) / stats.calls);
+            std::cout << line << std::endl;
+            if(stats.mismatches != 0) {
+                std::cout << "❌ " << stats.mismatches << " results differ from the C++ reference" << std::endl;
+            }
+        }
+        std::cout << "📐 DOT4.B saturates features to int8 (Q4 covers about +-8 sigma); decisions are checked on the"
+                  << " saturated data" << std::endl;
+    }
+    
+    void estimateEnergy() {
+        std::cout << "\n=== Core Energy Estimate ===" << std::endl;
+        std::cout << "Activity counted by the pipeline model, default 28nm coefficients, 200 MHz" << std::endl;
+        isa::PowerModel power;
+        
+        // A voice frame runs matchKeywords, then the core sleeps out the
+        // rest of the 64 ms frame in SLEEPM 1 until the next one is ready
+        engine = PIPELINE;
+        KernelStats voice = runKeywordKernel(100);
+        KernelStats auth = runBiometricKernel(20000);
+        KernelStats decision = runConnectivityKernel(20000);
+        engine = FUNCTIONAL;
+        
+        isa::Activity frame = voice.pipeline.activity;
+        uint64_t frameCycles = static_cast<uint64_t>(FRAME_SECONDS * CLOCK_HZ);
+        uint64_t activeCycles = voice.pipeline.cycles / voice.calls;
+        frame.counts[isa::sleepEvent(1)] += voice.calls * (frameCycles - std::min(frameCycles, activeCycles));
+        
+        const char* labels[] = {"voice frame (matchKeywords + sleep)", "authentication (isTrustedEnvironment)",
+                                "connectivity decision (evaluateTrustLevel)"};
+        const isa::Activity* activities[] = {&frame, &auth.pipeline.activity, &decision.pipeline.activity};
+        const KernelStats* runs[] = {&voice, &auth, &decision};
+        for(int i = 0; i < 3; i++) {
+            double perEvent = power.totalPicojoules(*activities[i]) / runs[i]->calls;
+            double seconds = static_cast<double>(runs[i]->pipeline.cycles) / runs[i]->calls / CLOCK_HZ;
+            char line[128];
+            std::snprintf(line, sizeof(line), "\n--- Per %s: %.3f nJ ---", labels[i], perEvent / 1e3);
+            std::cout << line << std::endl;
+            if(i == 0) {
+                std::snprintf(line, sizeof(line), "Active %.1f us of %.0f ms; average core power %.2f uW", seconds * 1e6,
+                              FRAME_SECONDS * 1e3, perEvent / FRAME_SECONDS / 1e6);
+            } else {
+                std::snprintf(line, sizeof(line), "Active %.3f us; %.1f mW while running", seconds * 1e6,
+                              perEvent / seconds / 1e9);
+            }
+            std::cout << line << std::endl;
+            std::cout << power.breakdown(*activities[i], runs[i]->calls);
+        }
+    }
+    
+    // Times an operation trace from a prototype's --trace mode (op_trace.h)
+    // on the pipeline with the baseline cache hierarchy, kernel by kernel
+    void replayTrace(const std::string& path) {
+        std::cout << "\n=== Trace-Driven Pipeline ===" << std::endl;
+        optrace::Reader reader;
+        std::string error;
+        if(!reader.load(path, error)) {
+            std::cout << "❌ " << error << std::endl;
+            return;
+        }
+        std::cout << path << ": " << reader.recordCount() << " operations in " << reader.byteCount()
+                  << " bytes" << std::endl;
+        isa::OperationSteps survey(reader);
+        isa::TraceStep step;
+        while(survey.next(step)) {
+        }
+        
+        for(int kernel = 0; kernel < optrace::TRACE_KERNEL_COUNT; kernel++) {
+            if(survey.calls[kernel] == 0) continue;
+            KernelStats stats;
+            stats.calls = survey.calls[kernel];
+            isa::MemoryHierarchy hierarchy((isa::HierarchyConfig()));
+            isa::PipelineConfig config;
+            config.memory = &hierarchy;
+            isa::Pipeline timing(machine, config);
+            isa::OperationSteps steps(reader, kernel);
+            if(!timing.replay(steps, 100 * reader.recordCount() + 1000)) {
+                std::cout << "❌ Replay of " << optrace::traceKernelName(kernel) << " did not finish" << std::endl;
+                continue;
+            }
+            stats.pipeline = timing.stats;
+            stats.instructions = timing.stats.instructions;
+            
+            // The same stream again under gshare for the predictor's view
+            isa::Gshare gshare(256, 8);
+            config.memory = nullptr;
+            config.predictor = &gshare;
+            isa::Pipeline predicted(machine, config);
+            steps.rewind();
+            predicted.replay(steps, 100 * reader.recordCount() + 1000);
+            
+            Kernel traced = {optrace::traceKernelName(kernel), "operation trace", 0, 0};
+            printPipelineStats(traced, stats);
+            const isa::PipelineStats& p = stats.pipeline;
+            char line[160];
+            std::snprintf(line, sizeof(line), "Calls: %llu, %.1f instructions and %.2f us per call at %.0f MHz; code laid out: %u bytes",
+                          static_cast<unsigned long long>(stats.calls), static_cast<double>(p.instructions) / stats.calls,
+                          1e6 * p.cycles / stats.calls / CLOCK_HZ, CLOCK_HZ / 1e6, steps.codeBytes());
+            std::cout << line << std::endl;
+            std::snprintf(line, sizeof(line), "Miss rate: L1I %.2f%%, L1D %.2f%%; branch mispredictions %.1f%% not-taken, %.1f%% gshare",
+                          100.0 * hierarchy.l1i.stats.missRate(), 100.0 * hierarchy.l1d.stats.missRate(),
+                          100.0 * p.mispredictionRate(), 100.0 * predicted.stats.mispredictionRate());
+            std::cout << line << std::endl;
+        }
+    }
+    
+    // Voice frames on one core and the connectivity scheduler's trust
+    // decisions on another, against both sharing a single core
+    void runMulticoreStudy() {
+        std::cout << "\n=== Multicore Study (MSI snooping bus, shared L2) ===" << std::endl;
+        const int frames = 20;
+        std::cout << "Every " << FRAME_SECONDS * 1e3 << " ms one voice frame (matchKeywords + mailbox post/read) and "
+                  << SCANS_PER_FRAME << " trust decisions (mailbox read + evaluateTrustLevel + post) are released "
+                  << "together; " << frames << " frames, private 1KB L1I / 2KB L1D per core" << std::endl;
+        std::cout << "  Configuration            Voice us mean/worst   Decision us mean/worst  Bus util  Bus wait"
+                  << "  BusRd  BusRdX  BusUpgr  Inval  Interv" << std::endl;
+        
+        struct Setup { const char* name; int cores; bool voice; bool decisions; uint32_t mailboxGap; };
+        const Setup setups[] = {
+            {"voice alone, 1 core", 1, true, false, 8},
+            {"decisions alone, 1 core", 1, false, true, 8},
+            {"both on 1 core", 1, true, true, 8},
+            {"2 cores", 2, true, true, 8},
+            {"2 cores, padded mailbox", 2, true, true, 64}
+        };
+        double aloneVoice = 0.0, aloneDecision = 0.0;
+        for(const auto& setup : setups) {
+            MulticoreRun run = runMulticore(setup.cores, frames, setup.voice, setup.decisions, setup.mailboxGap);
+            const isa::BusStats& bus = run.bus;
+            char line[200];
+            std::snprintf(line, sizeof(line), "  %-24s %9.1f / %-9.1f %9.1f / %-10.1f %6.2f%% %8llu %6llu %7llu %8llu %6llu %7llu",
+                          setup.name, run.voice.meanMicroseconds(), run.voice.worstMicroseconds(),
+                          run.decisions.meanMicroseconds(), run.decisions.worstMicroseconds(),
+                          run.activeCycles > 0 ? 100.0 * bus.busyCycles / run.activeCycles : 0.0,
+                          static_cast<unsigned long long>(bus.waitCycles), static_cast<unsigned long long>(bus.reads),
+                          static_cast<unsigned long long>(bus.readExclusives), static_cast<unsigned long long>(bus.upgrades),
+                          static_cast<unsigned long long>(bus.invalidations), static_cast<unsigned long long>(bus.interventions));
+            std::cout << line << std::endl;
+            if(run.mismatches != 0) {
+                std::cout << "❌ " << run.mismatches << " results differ from the C++ reference" << std::endl;
+            }
+            if(setup.cores == 1 && !setup.decisions) aloneVoice = run.voice.meanMicroseconds();
+            if(setup.cores == 1 && !setup.voice) aloneDecision = run.decisions.worstMicroseconds();
+            if(setup.cores == 2 && setup.mailboxGap == 8) {
+                std::cout << "📐 Contention on 2 cores: voice frame " << run.voice.meanMicroseconds() / aloneVoice
+                          << "x its time alone, decision batch " << run.decisions.worstMicroseconds() / aloneDecision
+                          << "x" << std::endl;
+            }
+        }
+        std::cout << "On one core jobs run to completion in release order, the decisions first. Budgets: voice frame "
+                  << "100000 us, trust decision " << DECISION_BUDGET * 1e6 << " us" << std::endl;
+    }
+    
+    // Runs frames periods of the voice / decision job mix on cores cores
+    // (voice on core 0, decisions on the last core). The connectivity
+    // mailbox sits mailboxGap bytes after the voice one, so 8 puts both in
+    // one L1D line.
+    MulticoreRun runMulticore(int cores, int frames, bool withVoice, bool withDecisions, uint32_t mailboxGap) {
+        isa::MultiCore system(cores, machine, isa::HierarchyConfig(), isa::BusConfig());
+        const uint32_t voiceMailbox = MAILBOX_ADDRESS;
+        const uint32_t connectivityMailbox = MAILBOX_ADDRESS + mailboxGap;
+        const uint32_t modelAddress = DATA_BASE + 4 * FEATURE_LENGTH;
+        const std::vector<std::string> trusted = {"home_wifi", "office_bt", "car_system", "personal_tablet"};
+        const std::vector<std::string> pool = {
+            "home_wifi", "smart_tv", "car_system", "office_bt", "printer_01",
+            "unknown_device_1", "strange_bt_device"
+        };
+        
+        std::vector<std::vector<int32_t>> models;
+        std::vector<uint32_t> trustedIds;
+        for(const auto& device : trusted) trustedIds.push_back(deviceId(device));
+        for(int i = 0; i < KEYWORD_MODELS; i++) {
+            models.push_back(std::vector<int32_t>(FEATURE_LENGTH, static_cast<int32_t>(std::lround(0.1f * (i + 1) * 256))));
+        }
+        for(int core = 0; core < cores; core++) {
+            for(int i = 0; i < KEYWORD_MODELS; i++) {
+                system.writeWords(core, modelAddress + 4 * FEATURE_LENGTH * i,
+                                  std::vector<uint32_t>(models[i].begin(), models[i].end()));
+            }
+            system.writeWords(core, TRUSTED_ADDRESS, trustedIds);
+            system.writeWords(core, MAILBOX_ADDRESS, std::vector<uint32_t>(mailboxGap / 4 + 2, 0));
+        }
+        
+        // Inputs and the host's answers for every job
+        std::mt19937 gen(61);
+        std::normal_distribution<float> dis(0.0f, 1.0f);
+        std::vector<std::vector<int32_t>> frameFeatures;
+        std::vector<std::vector<uint32_t>> scans;
+        std::vector<uint32_t> locations;
+        std::vector<std::deque<Job>> queues(cores);
+        const uint64_t period = static_cast<uint64_t>(FRAME_SECONDS * CLOCK_HZ);
+        for(int frame = 0; frame < frames; frame++) {
+            uint64_t release = frame * period;
+            if(withDecisions) {
+                for(int scan = 0; scan < SCANS_PER_FRAME; scan++) {
+                    std::vector<uint32_t> nearbyIds;
+                    int count = 1 + gen() % 4;
+                    for(int i = 0; i < count; i++) nearbyIds.push_back(deviceId(pool[gen() % pool.size()]));
+                    queues[cores - 1].push_back(Job{false, release, 0, static_cast<int>(scans.size()), 0});
+                    scans.push_back(nearbyIds);
+                    locations.push_back(scans.size() % 6);
+                }
+            }
+            if(withVoice) {
+                float mean = frame % 4 == 0 ? 3.5f : 0.0f;
+                std::vector<int32_t> features(FEATURE_LENGTH);
+                for(auto& feature : features) feature = static_cast<int32_t>(std::lround((mean + dis(gen)) * 16));
+                queues[0].push_back(Job{true, release, 0, static_cast<int>(frameFeatures.size()), 0});
+                frameFeatures.push_back(features);
+            }
+        }
+        
+        MulticoreRun run;
+        std::vector<uint32_t> sequences(2, 0);     // posts so far to the voice and connectivity mailboxes
+        while(true) {
+            bool pending = false;
+            for(int core = 0; core < cores; core++) {
+                isa::MultiCore::Core& state = system.core(core);
+                if(state.busy || queues[core].empty()) continue;
+                Job& job = queues[core].front();
+                if(job.release > system.clock) {
+                    pending = true;
+                    continue;
+                }
+                uint32_t result = state.machine.regs[1];
+                if(job.step > 0 && state.machine.status != isa::Machine::HALTED) run.mismatches++;
+                if(job.voice) {
+                    const std::vector<int32_t>& features = frameFeatures[job.index];
+                    switch(job.step) {
+                        case 0:
+                            system.writeWords(core, DATA_BASE, std::vector<uint32_t>(features.begin(), features.end()));
+                            system.start(core, kernels[3].entry, {DATA_BASE, modelAddress, static_cast<uint32_t>(KEYWORD_MODELS),
+                                                                  static_cast<uint32_t>(FEATURE_LENGTH)}, powerOffAddress);
+                            break;
+                        case 1:
+                            if(result != (keywordDetected(features, models) ? 1u : 0u)) run.mismatches++;
+                            system.start(core, kernels[12].entry, {voiceMailbox, result}, powerOffAddress);
+                            break;
+                        case 2:
+                            if(result != ++sequences[0]) run.mismatches++;
+                            system.publish(core, voiceMailbox, 8);
+                            job.posted = sequences[1];
+                            system.start(core, kernels[13].entry, {connectivityMailbox}, powerOffAddress);
+                            break;
+                        default:
+                            // A post the other core published during the read may or may not be seen
+                            if(result < job.posted || result > sequences[1]) run.mismatches++;
+                            run.voice.add(system.clock - job.release);
+                            queues[core].pop_front();
+                            continue;
+                    }
+                } else {
+                    const std::vector<uint32_t>& nearbyIds = scans[job.index];
+                    switch(job.step) {
+                        case 0:
+                            system.writeWords(core, SCAN_ADDRESS, nearbyIds);
+                            job.posted = sequences[0];
+                            system.start(core, kernels[13].entry, {voiceMailbox}, powerOffAddress);
+                            break;
+                        case 1:
+                            if(result < job.posted || result > sequences[0]) run.mismatches++;
+                            system.start(core, kernels[2].entry, {SCAN_ADDRESS, static_cast<uint32_t>(nearbyIds.size()),
+                                                                  TRUSTED_ADDRESS, static_cast<uint32_t>(trustedIds.size()),
+                                                                  locations[job.index]}, powerOffAddress);
+                            break;
+                        case 2:
+                            if(result != expectedTrustLevel(nearbyIds, trustedIds, locations[job.index])) run.mismatches++;
+                            system.start(core, kernels[12].entry, {connectivityMailbox, result}, powerOffAddress);
+                            break;
+                        default:
+                            if(result != ++sequences[1]) run.mismatches++;
+                            system.publish(core, connectivityMailbox, 8);
+                            run.decisions.add(system.clock - job.release);
+                            queues[core].pop_front();
+                            continue;
+                    }
+                }
+                job.step++;
+            }
+            
+            if(!system.idle()) {
+                system.step();
+                run.activeCycles++;
+            } else if(pending) {
+                // Every core sleeps until the next release
+                uint64_t next = UINT64_MAX;
+                for(const auto& queue : queues) {
+                    if(!queue.empty()) next = std::min(next, queue.front().release);
+                }
+                system.sleepUntil(next);
+            } else {
+                bool finished = true;
+                for(const auto& queue : queues) finished = finished && queue.empty();
+                if(finished) break;
+            }
+        }
+        run.bus = system.bus.stats;
+        return run;
+    }
+    
+    // The heterogeneous pair: a dual-issue core with a single-cycle MAC
+    // array and larger L1s, and a minimal single-issue core with an
+    // iterative multiplier and small L1s, on one bus at the same clock
+    static std::vector<isa::CoreConfig> bigLittleCores() {
+        isa::PipelineConfig big;
+        big.issueWidth = 2;
+        big.macLatency = 1;
+        isa::HierarchyConfig bigCaches;
+        bigCaches.l1i = isa::CacheConfig(2048, 2, 16);
+        bigCaches.l1d = isa::CacheConfig(4096, 2, 16);
+        isa::PipelineConfig little;
+        little.macLatency = 4;
+        isa::HierarchyConfig littleCaches;
+        littleCaches.l1i = isa::CacheConfig(512, 2, 16);
+        littleCaches.l1d = isa::CacheConfig(1024, 2, 16);
+        return {isa::CoreConfig("big", big, bigCaches), isa::CoreConfig("LITTLE", little, littleCaches)};
+    }
+    
+    // The big core's wider datapath, second lane and larger arrays cost more
+    // per event and leak more; the little core the reverse
+    static isa::PowerModel bigLittlePower(int core) {
+        isa::PowerModel power;
+        if(core == BIG) {
+            power.scale(1.3, 2.5);
+        } else {
+            power.scale(0.8, 0.6);
+        }
+        return power;
+    }
+    
+    // Profiles every task class alone on each core, then runs the mixed
+    // workload under each placement policy and compares energy-delay products
+    void runBigLittleStudy() {
+        std::cout << "\n=== big.LITTLE Scheduling Study ===" << std::endl;
+        const int windows = 8;
+        const std::vector<isa::CoreConfig> configs = bigLittleCores();
+        std::cout << "big: dual issue, 1-cycle MAC array, 2KB L1I / 4KB L1D; LITTLE: single issue, 4-cycle MAC, "
+                  << "512B L1I / 1KB L1D; shared L2 and bus, both at " << CLOCK_HZ / 1e6 << " MHz" << std::endl;
+        std::cout << "A window releases 1 voice frame (matchKeywords), " << AUTHS_PER_WINDOW
+                  << " auth requests (hammingDistance + isTrustedEnvironment) and " << SCANS_PER_FRAME
+                  << " scan ticks (evaluateTrustLevel) at once; the next is released when it completes" << std::endl;
+        
+        const char* classNames[TASK_CLASSES] = {"voice frame", "auth request", "scan tick"};
+        TaskProfile profile;
+        std::cout << "\n--- Task profile (each class alone) ---" << std::endl;
+        std::cout << "  Task class      big cycles    big nJ  LITTLE cycles  LITTLE nJ  big speedup" << std::endl;
+        for(int taskClass = 0; taskClass < TASK_CLASSES; taskClass++) {
+            int mix[TASK_CLASSES] = {0, 0, 0};
+            mix[taskClass] = taskClass == TASK_VOICE ? 1 : taskClass == TASK_AUTH ? AUTHS_PER_WINDOW : SCANS_PER_FRAME;
+            for(int core = 0; core < 2; core++) {
+                BigLittleRun run = runBigLittle(core == BIG ? PLACE_ALL_BIG : PLACE_ALL_LITTLE, windows, mix, nullptr);
+                isa::PowerModel power = bigLittlePower(core);
+                isa::Activity busy = run.activity[core];
+                busy.counts[isa::EVENT_SLEEP_LIGHT] = busy.counts[isa::EVENT_SLEEP_DEEP] = 0;
+                profile.cycles[taskClass][core] = static_cast<double>(run.service[taskClass].totalCycles) / run.service[taskClass].jobs;
+                profile.nanojoules[taskClass][core] = power.totalPicojoules(busy) / run.service[taskClass].jobs / 1e3;
+                if(run.mismatches != 0) {
+                    std::cout << "❌ " << run.mismatches << " results differ from the C++ reference" << std::endl;
+                }
+            }
+            char line[128];
+            std::snprintf(line, sizeof(line), "  %-14s %11.1f %9.2f %14.1f %10.2f %11.2fx", classNames[taskClass],
+                          profile.cycles[taskClass][BIG], profile.nanojoules[taskClass][BIG],
+                          profile.cycles[taskClass][LITTLE], profile.nanojoules[taskClass][LITTLE],
+                          profile.cycles[taskClass][LITTLE] / profile.cycles[taskClass][BIG]);
+            std::cout << line << std::endl;
+        }
+        
+        const char* placementNames[PLACEMENTS] = {"all big", "all LITTLE", "by profile", "greedy (big first)", "EDP-aware"};
+        const int mix[TASK_CLASSES] = {1, AUTHS_PER_WINDOW, SCANS_PER_FRAME};
+        std::cout << "\n--- Mixed workload, " << windows << " windows ---" << std::endl;
+        std::cout << "  Policy              Voice us  Auth us  Scan us  on big V/A/S   Makespan us  Energy nJ (active/sleep)"
+                  << "  EDP nJ*us" << std::endl;
+        double bestEdp = 0.0;
+        int best = 0;
+        for(int placement = 0; placement < PLACEMENTS; placement++) {
+            BigLittleRun run = runBigLittle(static_cast<Placement>(placement), windows, mix, &profile);
+            double active = 0.0, sleep = 0.0;
+            for(int core = 0; core < 2; core++) {
+                isa::PowerModel power = bigLittlePower(core);
+                double asleep = power.picojoules(run.activity[core], isa::EVENT_SLEEP_LIGHT) +
+                                power.picojoules(run.activity[core], isa::EVENT_SLEEP_DEEP);
+                sleep += asleep / windows / 1e3;
+                active += (power.totalPicojoules(run.activity[core]) - asleep) / windows / 1e3;
+            }
+            double makespan = 1e6 * run.makespan / windows / CLOCK_HZ;
+            double edp = (active + sleep) * makespan;
+            char onBig[24];
+            std::snprintf(onBig, sizeof(onBig), "%d/%d/%d", static_cast<int>(run.placed[TASK_VOICE][BIG] / windows),
+                          static_cast<int>(run.placed[TASK_AUTH][BIG] / windows),
+                          static_cast<int>(run.placed[TASK_SCAN][BIG] / windows));
+            char line[200];
+            std::snprintf(line, sizeof(line), "  %-18s %9.1f %8.1f %8.1f  %-12s %12.1f %9.1f (%.1f/%.1f) %10.0f",
+                          placementNames[placement], run.latency[TASK_VOICE].meanMicroseconds(),
+                          run.latency[TASK_AUTH].meanMicroseconds(), run.latency[TASK_SCAN].meanMicroseconds(), onBig,
+                          makespan, active + sleep, active, sleep, edp);
+            std::cout << line << std::endl;
+            if(run.mismatches != 0) {
+                std::cout << "❌ " << run.mismatches << " results differ from the C++ reference" << std::endl;
+            }
+            if(placement == 0 || edp < bestEdp) {
+                bestEdp = edp;
+                best = placement;
+            }
+        }
+        std::cout << "📐 Lowest energy-delay product: " << placementNames[best] << std::endl;
+        std::cout << "Latency is from the window's release; energy is per window with the idle core in light sleep, "
+                  << "or deep sleep when the policy never uses it" << std::endl;
+    }
+    
+    // Runs windows of mix[] tasks per class on the big.LITTLE pair. Tasks are
+    // placed non-preemptively, highest class first; a task whose chosen core
+    // is busy waits while later ones may still take the other core.
+    BigLittleRun runBigLittle(Placement placement, int windows, const int mix[TASK_CLASSES], const TaskProfile* profile) {
+        isa::MultiCore system(bigLittleCores(), machine, isa::BusConfig());
+        const uint32_t modelAddress = DATA_BASE + 4 * FEATURE_LENGTH;
+        const std::vector<std::string> trusted = {"home_wifi", "office_bt", "car_system", "personal_tablet"};
+        const std::vector<std::string> scanPool = {
+            "home_wifi", "smart_tv", "car_system", "office_bt", "printer_01",
+            "unknown_device_1", "strange_bt_device"
+        };
+        const std::vector<std::vector<std::string>> profiles = {
+            {"home_bt", "car_bt"}, {"office_wifi"}, {"home_bt", "personal_device"}
+        };
+        const std::vector<std::string> authPool = {
+            "home_bt", "unknown_device", "office_wifi", "car_bt", "tv_system",
+            "printer_bt", "public_wifi", "strange_device"
+        };
+        
+        std::vector<std::vector<int32_t>> models;
+        std::vector<uint32_t> trustedIds;
+        std::vector<std::vector<uint32_t>> profileIds(profiles.size());
+        for(const auto& device : trusted) trustedIds.push_back(deviceId(device));
+        for(size_t i = 0; i < profiles.size(); i++) {
+            for(const auto& device : profiles[i]) profileIds[i].push_back(deviceId(device));
+        }
+        for(int i = 0; i < KEYWORD_MODELS; i++) {
+            models.push_back(std::vector<int32_t>(FEATURE_LENGTH, static_cast<int32_t>(std::lround(0.1f * (i + 1) * 256))));
+        }
+        std::mt19937 gen(61);
+        std::normal_distribution<float> dis(0.0f, 1.0f);
+        std::vector<uint32_t> enrolled(TEMPLATE_WORDS);
+        for(auto& word : enrolled) word = gen();
+        for(int core = 0; core < system.size(); core++) {
+            for(int i = 0; i < KEYWORD_MODELS; i++) {
+                system.writeWords(core, modelAddress + 4 * FEATURE_LENGTH * i,
+                                  std::vector<uint32_t>(models[i].begin(), models[i].end()));
+            }
+            system.writeWords(core, TRUSTED_ADDRESS, trustedIds);
+            system.writeWords(core, ENROLLED_ADDRESS, enrolled);
+            for(int user = 0; user < USER_COUNT; user++) {
+                system.writeWords(core, USER_TABLE + USER_RECORD_BYTES * user, profileIds[user % profiles.size()]);
+            }
+        }
+        
+        // Inputs for every task, the same for every policy
+        struct Inputs {
+            std::vector<int32_t> features;
+            std::vector<uint32_t> probe;
+            uint32_t user;
+            std::vector<uint32_t> nearbyIds;
+            uint32_t location;
+        };
+        std::vector<Task> tasks;
+        std::vector<Inputs> inputs;
+        for(int window = 0; window < windows; window++) {
+            for(int taskClass = 0; taskClass < TASK_CLASSES; taskClass++) {
+                for(int i = 0; i < mix[taskClass]; i++) {
+                    Inputs in;
+                    in.user = 0;
+                    in.location = 0;
+                    if(taskClass == TASK_VOICE) {
+                        float mean = window % 4 == 0 ? 3.5f : 0.0f;
+                        in.features.resize(FEATURE_LENGTH);
+                        for(auto& feature : in.features) feature = static_cast<int32_t>(std::lround((mean + dis(gen)) * 16));
+                    } else if(taskClass == TASK_AUTH) {
+                        in.probe = enrolled;
+                        int flips = gen() % 256;
+                        for(int flip = 0; flip < flips; flip++) {
+                            uint32_t bit = gen() % (32 * TEMPLATE_WORDS);
+                            in.probe[bit / 32] ^= 1u << (bit % 32);
+                        }
+                        in.user = gen() % USER_COUNT;
+                        for(int device = 0; device < 4; device++) in.nearbyIds.push_back(deviceId(authPool[gen() % authPool.size()]));
+                    } else {
+                        int count = 1 + gen() % 4;
+                        for(int device = 0; device < count; device++) in.nearbyIds.push_back(deviceId(scanPool[gen() % scanPool.size()]));
+                        in.location = static_cast<uint32_t>(inputs.size() % 6);
+                    }
+                    tasks.push_back(Task{taskClass, window, 0, 0, 0});
+                    inputs.push_back(in);
+                }
+            }
+        }
+        
+        BigLittleRun run;
+        std::vector<int> running(system.size(), -1);
+        std::vector<int> ready;                 // task indices, in class then release order
+        size_t released = 0;
+        int remaining = 0;                      // tasks of the current window not yet finished
+        while(true) {
+            // Release the next window once the current one has finished
+            if(remaining == 0) {
+                if(released == tasks.size()) break;
+                int window = tasks[released].window;
+                for(; released < tasks.size() && tasks[released].window == window; released++) {
+                    tasks[released].release = system.clock;
+                    ready.push_back(static_cast<int>(released));
+                    remaining++;
+                }
+                std::stable_sort(ready.begin(), ready.end(), [&](int a, int b) {
+                    return tasks[a].taskClass < tasks[b].taskClass;
+                });
+            }
+            
+            // Advance the task on every core whose call has returned
+            for(int core = 0; core < system.size(); core++) {
+                isa::MultiCore::Core& state = system.core(core);
+                if(state.busy || running[core] < 0) continue;
+                Task& task = tasks[running[core]];
+                const Inputs& in = inputs[running[core]];
+                uint32_t result = state.machine.regs[1];
+                if(state.machine.status != isa::Machine::HALTED) run.mismatches++;
+                bool finished = true;
+                if(task.taskClass == TASK_VOICE) {
+                    if(result != (keywordDetected(in.features, models) ? 1u : 0u)) run.mismatches++;
+                } else if(task.taskClass == TASK_AUTH && task.step == 1) {
+                    uint32_t expected = 0;
+                    for(int i = 0; i < TEMPLATE_WORDS; i++) expected += isa::bitCount(enrolled[i] ^ in.probe[i]);
+                    if(result != expected) run.mismatches++;
+                    system.writeWords(core, AUTH_NEARBY_ADDRESS, in.nearbyIds);
+                    const std::vector<uint32_t>& userProfile = profileIds[in.user % profiles.size()];
+                    system.start(core, kernels[1].entry, {USER_TABLE + USER_RECORD_BYTES * in.user,
+                                                          static_cast<uint32_t>(userProfile.size()), AUTH_NEARBY_ADDRESS,
+                                                          static_cast<uint32_t>(in.nearbyIds.size())}, powerOffAddress);
+                    task.step++;
+                    finished = false;
+                } else if(task.taskClass == TASK_AUTH) {
+                    bool expected = false;
+                    for(uint32_t id : profileIds[in.user % profiles.size()]) {
+                        expected = expected || std::find(in.nearbyIds.begin(), in.nearbyIds.end(), id) != in.nearbyIds.end();
+                    }
+                    if(result != (expected ? 1u : 0u)) run.mismatches++;
+                } else {
+                    if(result != expectedTrustLevel(in.nearbyIds, trustedIds, in.location)) run.mismatches++;
+                }
+                if(finished) {
+                    run.latency[task.taskClass].add(system.clock - task.release);
+                    run.service[task.taskClass].add(system.clock - task.start);
+                    running[core] = -1;
+                    remaining--;
+                }
+            }
+            
+            // Place ready tasks, highest class first
+            for(size_t r = 0; r < ready.size();) {
+                Task& task = tasks[ready[r]];
+                int core = placeTask(placement, task.taskClass, running, tasks, system.clock, profile);
+                if(core < 0 || running[core] >= 0) {
+                    r++;
+                    continue;
+                }
+                const Inputs& in = inputs[ready[r]];
+                if(task.taskClass == TASK_VOICE) {
+                    system.writeWords(core, DATA_BASE, std::vector<uint32_t>(in.features.begin(), in.features.end()));
+                    system.start(core, kernels[3].entry, {DATA_BASE, modelAddress, static_cast<uint32_t>(KEYWORD_MODELS),
+                                                          static_cast<uint32_t>(FEATURE_LENGTH)}, powerOffAddress);
+                } else if(task.taskClass == TASK_AUTH) {
+                    system.writeWords(core, PROBE_ADDRESS, in.probe);
+                    system.start(core, kernels[4].entry, {ENROLLED_ADDRESS, PROBE_ADDRESS,
+                                                          static_cast<uint32_t>(TEMPLATE_WORDS)}, powerOffAddress);
+                } else {
+                    system.writeWords(core, SCAN_ADDRESS, in.nearbyIds);
+                    system.start(core, kernels[2].entry, {SCAN_ADDRESS, static_cast<uint32_t>(in.nearbyIds.size()),
+                                                          TRUSTED_ADDRESS, static_cast<uint32_t>(trustedIds.size()),
+                                                          in.location}, powerOffAddress);
+                }
+                task.step = 1;
+                task.start = system.clock;
+                run.placed[task.taskClass][core]++;
+                running[core] = ready[r];
+                ready.erase(ready.begin() + r);
+            }
+            
+            if(!system.idle()) system.step();
+        }
+        
+        // A core the policy never uses is power gated; otherwise it waits
+        // for work in light sleep
+        run.makespan = system.clock;
+        for(int core = 0; core < system.size(); core++) {
+            run.activity[core] = system.core(core).pipeline.stats.activity;
+            bool used = false;
+            for(const auto& counts : run.placed) used = used || counts[core] > 0;
+            run.activity[core].counts[used ? isa::EVENT_SLEEP_LIGHT : isa::EVENT_SLEEP_DEEP] += system.sleepCycles(core);
+        }
+        return run;
+    }
+    
+    // The core a ready task of taskClass should run on, or -1 to leave it
+    // waiting. By-profile placement sends each class to the core with the
+    // lower profiled energy-delay product for one task run alone; EDP-aware
+    // placement weighs each core's profiled energy by the time the task would
+    // finish there, counting the wait for a busy core.
+    static int placeTask(Placement placement, int taskClass, const std::vector<int>& running,
+                         const std::vector<Task>& tasks, uint64_t clock, const TaskProfile* profile) {
+        switch(placement) {
+            case PLACE_ALL_BIG:
+                return BIG;
+            case PLACE_ALL_LITTLE:
+                return LITTLE;
+            case PLACE_BY_PROFILE:
+                return profile->nanojoules[taskClass][BIG] * profile->cycles[taskClass][BIG] <=
+                       profile->nanojoules[taskClass][LITTLE] * profile->cycles[taskClass][LITTLE] ? BIG : LITTLE;
+            case PLACE_GREEDY:
+                return running[BIG] < 0 ? BIG : running[LITTLE] < 0 ? LITTLE : -1;
+            default: {
+                double bestCost = 0.0;
+                int best = BIG;
+                for(int core = 0; core < 2; core++) {
+                    double wait = 0.0;
+                    if(running[core] >= 0) {
+                        const Task& current = tasks[running[core]];
+                        wait = std::max(0.0, profile->cycles[current.taskClass][core] - (clock - current.start));
+                    }
+                    double cost = profile->nanojoules[taskClass][core] * (wait + profile->cycles[taskClass][core]);
+                    if(core == BIG || cost < bestCost) {
+                        bestCost = cost;
+                        best = core;
+                    }
+                }
+                return best;
+            }
+        }
+    }
+    
+    struct VoiceLoopRun {
+        uint64_t frames;
+        isa::PipelineStats core;
+        JobLatency latency;         // frame complete to result
+        uint64_t wakeups;
+        uint64_t overruns;
+        int mismatches;
+        
+        VoiceLoopRun() : frames(0), wakeups(0), overruns(0), mismatches(0) {}
+    };
+    
+    // The voice loop as the chip runs it: the DMA engine streams feature
+    // frames into a ring and interrupts the core, which sleeps in between,
+    // against the same loop polling the ring without sleeping
+    void runInterruptDrivenVoice() {
+        std::cout << "\n=== Interrupt-Driven Voice Loop (DMA + SLEEPM) ===" << std::endl;
+        const uint64_t cyclesPerWord = static_cast<uint64_t>(FRAME_SECONDS * CLOCK_HZ) / FEATURE_LENGTH;
+        std::cout << "The DMA engine moves the audio front end's " << FEATURE_LENGTH << " feature words per "
+                  << FRAME_SECONDS * 1e3 << " ms frame (one every " << cyclesPerWord << " cycles) into a "
+                  << VOICE_RING_SLOTS << "-frame ring; voiceService scores each frame with matchKeywords. "
+                  << "Pipeline model, baseline caches, " << CLOCK_HZ / 1e6 << " MHz" << std::endl;
+        isa::PowerModel power;
+        
+        std::cout << "  Loop                    Frames  Active cycles/frame  Asleep    Wake-ups  Latency us mean/worst"
+                  << "  Overruns  Core nJ/frame  Avg power uW" << std::endl;
+        const bool modes[] = {true, false};
+        const int frameCounts[] = {20, 2};     // polling clocks every cycle of the frame
+        for(int m = 0; m < 2; m++) {
+            VoiceLoopRun run = runVoiceService(frameCounts[m], modes[m]);
+            double frames = static_cast<double>(run.frames);
+            double nanojoules = power.totalPicojoules(run.core.activity) / frames / 1e3;
+            char line[200];
+            std::snprintf(line, sizeof(line), "  %-22s %7llu %20.0f %7.3f%% %10llu %10.1f / %-10.1f %8llu %14.1f %13.2f",
+                          modes[m] ? "interrupt + SLEEPM 1" : "polling the ring", static_cast<unsigned long long>(run.frames),
+                          (run.core.cycles - run.core.sleepCycles) / frames,
+                          100.0 * run.core.sleepCycles / run.core.cycles, static_cast<unsigned long long>(run.wakeups),
+                          run.latency.meanMicroseconds(), run.latency.worstMicroseconds(),
+                          static_cast<unsigned long long>(run.overruns), nanojoules,
+                          power.totalPicojoules(run.core.activity) / (run.core.cycles / CLOCK_HZ) / 1e6);
+            std::cout << line << std::endl;
+            if(run.mismatches != 0) {
+                std::cout << "❌ " << run.mismatches << " results differ from the C++ reference" << std::endl;
+            }
+        }
+        std::cout << "Latency runs from the DMA completing a frame to voiceService marking it consumed. "
+                  << "The DMA engine's own energy is not modelled" << std::endl;
+    }
+    
+    // voiceService over frames DMA frames; with interrupts off SLEEPM does
+    // not wait and the core spins on the ring
+    VoiceLoopRun runVoiceService(int frames, bool interrupts) {
+        const uint32_t modelAddress = DATA_BASE + 4 * FEATURE_LENGTH;
+        const uint64_t cyclesPerWord = static_cast<uint64_t>(FRAME_SECONDS * CLOCK_HZ) / FEATURE_LENGTH;
+        isa::MemoryHierarchy hierarchy((isa::HierarchyConfig()));
+        isa::PipelineConfig config;
+        config.memory = &hierarchy;
+        isa::Pipeline core(machine, config);
+        isa::InterruptController controller(machine);
+        controller.enable(isa::IRQ_DMA_FRAME);
+        isa::DmaEngine dma(machine, controller, isa::DmaConfig(VOICE_CONTROL_ADDRESS, VOICE_RING_ADDRESS, VOICE_RING_SLOTS,
+                                                               FEATURE_LENGTH, cyclesPerWord), &hierarchy);
+        
+        std::vector<std::vector<int32_t>> models;
+        for(int i = 0; i < KEYWORD_MODELS; i++) {
+            models.push_back(std::vector<int32_t>(FEATURE_LENGTH, static_cast<int32_t>(std::lround(0.1f * (i + 1) * 256))));
+            writeWords(modelAddress + 4 * FEATURE_LENGTH * i, std::vector<uint32_t>(models[i].begin(), models[i].end()));
+        }
+        std::mt19937 gen(61);
+        std::normal_distribution<float> dis(0.0f, 1.0f);
+        uint32_t expected = 0;
+        for(int frame = 0; frame < frames; frame++) {
+            float mean = frame % 4 == 0 ? 3.5f : 0.0f;
+            std::vector<int32_t> features(FEATURE_LENGTH);
+            for(auto& feature : features) feature = static_cast<int32_t>(std::lround((mean + dis(gen)) * 16));
+            if(keywordDetected(features, models)) expected++;
+            dma.feed(std::vector<uint32_t>(features.begin(), features.end()));
+        }
+        
+        machine.reset();
+        machine.wakeOnInterrupt = interrupts;
+        dma.start(0);
+        writeWords(VOICE_CONTROL_ADDRESS + 4 * isa::DMA_CONTROL_WORDS,
+                   {modelAddress, static_cast<uint32_t>(KEYWORD_MODELS), static_cast<uint32_t>(frames)});
+        machine.regs[1] = VOICE_CONTROL_ADDRESS;
+        machine.regs[isa::REG_LR] = powerOffAddress;
+        machine.pc = kernels[14].entry;
+        core.reset(machine.pc);
+        
+        VoiceLoopRun run;
+        uint32_t served = 0;
+        while(true) {
+            dma.clock(core.stats.cycles);
+            if(core.asleep()) {
+                uint64_t next = dma.nextEvent();
+                if(next == UINT64_MAX) break;   // nothing left to wake it
+                core.sleep(next - core.stats.cycles);
+                continue;
+            }
+            if(!core.cycle()) break;
+            uint32_t consumed = machine.readWord(VOICE_CONTROL_ADDRESS + 4 * isa::DMA_CONSUMED);
+            if(consumed != served) {
+                run.latency.add(core.stats.cycles - dma.completedAt[served]);
+                served = consumed;
+            }
+        }
+        machine.wakeOnInterrupt = false;
+        
+        if(machine.status != isa::Machine::HALTED) {
+            std::cout << "❌ voiceService stopped at pc 0x" << std::hex << machine.pc << std::dec << ": "
+                      << (machine.status == isa::Machine::FAULT ? machine.fault : "asleep with no frames left") << std::endl;
+            run.mismatches++;
+        } else if(machine.regs[1] != expected) {
+            run.mismatches++;
+        }
+        run.frames = served;
+        run.core = core.stats;
+        run.wakeups = controller.wakeups;
+        run.overruns = dma.overruns;
+        return run;
+    }
+    
+    // Totals of one detailed (pipeline + caches) stretch of the session
+    struct DetailedRun {
+        uint64_t cycles;
+        uint64_t instructions;
+        double picojoules;
+        double seconds;         // host time
+        
+        DetailedRun() : cycles(0), instructions(0), picojoules(0.0), seconds(0.0) {}
+        
+        double cpi() const { return instructions > 0 ? static_cast<double>(cycles) / instructions : 0.0; }
+    };
+    
+    // A long always-on session timed in full on the pipeline, then by
+    // SimPoint-style sampling: profile, cluster, checkpoint, and simulate
+    // only the representative intervals in detail
+    void runSampledSimulation() {
+        std::cout << "\n=== Sampled Simulation (SimPoint-style) ===" << std::endl;
+        const int passes = 16;
+        const uint64_t interval = 20000;
+        const uint64_t warmup = 2 * interval;       // enough to refill the 16KB L2 after a cold start
+        const int maxClusters = 10;
+        std::vector<uint32_t> expected;
+        uint32_t records = buildSession(expected);
+        machine.reset();
+        machine.regs[1] = SESSION_SCHEDULE_ADDRESS;
+        machine.regs[2] = records;
+        machine.regs[3] = passes;
+        machine.regs[isa::REG_LR] = powerOffAddress;
+        machine.pc = kernels[15].entry;
+        const isa::Machine::Checkpoint start = machine.save();
+        double sessionSeconds = passes * FRAMES_PER_PASS * FRAME_SECONDS;
+        std::cout << "Session: " << passes << " passes of " << FRAMES_PER_PASS << " frames (" << sessionSeconds
+                  << " s of always-on listening), " << records << " calls per pass: quiet, speech, scanning and "
+                  << "authentication phases. Detailed = pipeline with the baseline caches" << std::endl;
+        
+        // Reference: the whole session in detail
+        machine.restore(start);
+        DetailedRun full = runDetailed(UINT64_MAX, 0);
+        int mismatches = 0;
+        for(uint32_t i = 0; i < records; i++) {
+            if(machine.readWord(SESSION_SCHEDULE_ADDRESS + SCHEDULE_RECORD_BYTES * i + 24) != expected[i]) mismatches++;
+        }
+        if(machine.status != isa::Machine::HALTED) mismatches++;
+        
+        // Sampling: basic-block vectors on the functional ISS, clustering,
+        // checkpoints from a fast-forward pass, then the chosen intervals in
+        // detail after a warm-up
+        auto t0 = std::chrono::high_resolution_clock::now();
+        machine.restore(start);
+        isa::BlockVectorProfile profile(interval);
+        profile.profile(machine);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::vector<isa::SimPoint> points = profile.choose(maxClusters);
+        std::sort(points.begin(), points.end(), [](const isa::SimPoint& a, const isa::SimPoint& b) {
+            return a.interval < b.interval;
+        });
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::vector<isa::Machine::Checkpoint> checkpoints;
+        machine.restore(start);
+        for(const auto& point : points) {
+            uint64_t at = point.interval * interval - std::min<uint64_t>(point.interval * interval, warmup);
+            if(at > machine.instret) machine.run(at - machine.instret);
+            checkpoints.push_back(machine.save());
+        }
+        auto t3 = std::chrono::high_resolution_clock::now();
+        
+        uint64_t instructions = 0;
+        for(uint64_t length : profile.lengths) instructions += length;
+        double cycles = 0.0, picojoules = 0.0;
+        uint64_t detailedInstructions = 0;
+        std::vector<DetailedRun> samples;
+        for(size_t i = 0; i < points.size(); i++) {
+            machine.restore(checkpoints[i]);
+            uint64_t skip = points[i].interval * interval - checkpoints[i].instret;
+            DetailedRun sample = runDetailed(interval, skip);
+            samples.push_back(sample);
+            cycles += points[i].weight * sample.cpi() * instructions;
+            picojoules += points[i].weight * sample.picojoules / std::max<uint64_t>(sample.instructions, 1) * instructions;
+            detailedInstructions += skip + sample.instructions;
+        }
+        auto t4 = std::chrono::high_resolution_clock::now();
+        double profileSeconds = std::chrono::duration<double>(t1 - t0).count();
+        double clusterSeconds = std::chrono::duration<double>(t2 - t1).count();
+        double checkpointSeconds = std::chrono::duration<double>(t3 - t2).count();
+        double detailSeconds = std::chrono::duration<double>(t4 - t3).count();
+        double sampledSeconds = profileSeconds + clusterSeconds + checkpointSeconds + detailSeconds;
+        
+        std::cout << "\n" << profile.lengths.size() << " intervals of " << interval << " instructions; BIC chose "
+                  << profile.clusters << " clusters (of up to " << maxClusters << ")" << std::endl;
+        std::cout << "  Interval  Weight    CPI" << std::endl;
+        for(size_t i = 0; i < points.size(); i++) {
+            char line[64];
+            std::snprintf(line, sizeof(line), "  %8d  %5.1f%%  %5.3f", points[i].interval, 100.0 * points[i].weight,
+                          samples[i].cpi());
+            std::cout << line << std::endl;
+        }
+        
+        char line[200];
+        std::cout << "\n                     Cycles         CPI    Core uJ   Host s" << std::endl;
+        std::snprintf(line, sizeof(line), "  Full detailed %13llu  %10.3f %10.2f %8.3f", static_cast<unsigned long long>(full.cycles),
+                      full.cpi(), full.picojoules / 1e6, full.seconds);
+        std::cout << line << std::endl;
+        std::snprintf(line, sizeof(line), "  Sampled       %13.0f  %10.3f %10.2f %8.3f", cycles, cycles / instructions,
+                      picojoules / 1e6, sampledSeconds);
+        std::cout << line << std::endl;
+        std::snprintf(line, sizeof(line), "📐 Error: cycles %+.2f%%, energy %+.2f%%; %.1fx faster, %.1f%% of instructions in detail",
+                      100.0 * (cycles - full.cycles) / full.cycles, 100.0 * (picojoules - full.picojoules) / full.picojoules,
+                      full.seconds / sampledSeconds, 100.0 * detailedInstructions / instructions);
+        std::cout << line << std::endl;
+        std::snprintf(line, sizeof(line), "Sampled time: profile %.3f s, cluster %.3f s, checkpoints %.3f s, detail %.3f s",
+                      profileSeconds, clusterSeconds, checkpointSeconds, detailSeconds);
+        std::cout << line << std::endl;
+        
+        // Profiling and fast-forward grow with the run; the detailed samples
+        // do not while the phases stay the same
+        double scale = 3600.0 / sessionSeconds;
+        std::snprintf(line, sizeof(line), "An hour of listening (%.0fx this session): about %.0f s in full detail, %.1f s sampled",
+                      scale, full.seconds * scale, (profileSeconds + checkpointSeconds) * scale + clusterSeconds + detailSeconds);
+        std::cout << line << std::endl;
+        if(mismatches != 0) {
+            std::cout << "❌ " << mismatches << " results differ from the C++ reference" << std::endl;
+        }
+    }
+    
+    // Runs the machine's current program on a fresh pipeline and caches:
+    // skip instructions of warm-up, then up to instructions measured
+    DetailedRun runDetailed(uint64_t instructions, uint64_t skip) {
+        isa::MemoryHierarchy hierarchy((isa::HierarchyConfig()));
+        isa::PipelineConfig config;
+        config.memory = &hierarchy;
+        isa::Pipeline core(machine, config);
+        isa::PowerModel power;
+        auto start = std::chrono::high_resolution_clock::now();
+        core.reset(machine.pc);
+        bool running = true;
+        while(running && core.stats.instructions < skip) running = core.cycle();
+        isa::PipelineStats warm = core.stats;
+        uint64_t end = instructions == UINT64_MAX ? UINT64_MAX : skip + instructions;
+        while(running && core.stats.instructions < end) running = core.cycle();
+        auto stop = std::chrono::high_resolution_clock::now();
+        
+        DetailedRun run;
+        run.cycles = core.stats.cycles - warm.cycles;
+        run.instructions = core.stats.instructions - warm.instructions;
+        run.picojoules = power.totalPicojoules(core.stats.activity) - power.totalPicojoules(warm.activity);
+        run.seconds = std::chrono::duration<double>(stop - start).count();
+        return run;
+    }
+    
+    // Lays out the inputs and one pass of the always-on schedule: every
+    // 64 ms frame runs matchKeywords and a few scan ticks, through quiet,
+    // speech, scanning and authentication phases. Returns the record count
+    // and the result each record should get.
+    uint32_t buildSession(std::vector<uint32_t>& expected) {
+        const uint32_t modelAddress = DATA_BASE + 4 * FEATURE_LENGTH;
+        const std::vector<std::string> trusted = {"home_wifi", "office_bt", "car_system", "personal_tablet"};
+        const std::vector<std::string> scanPool = {
+            "home_wifi", "smart_tv", "car_system", "office_bt", "printer_01",
+            "unknown_device_1", "strange_bt_device"
+        };
+        const std::vector<std::vector<std::string>> profiles = {
+            {"home_bt", "car_bt"}, {"office_wifi"}, {"home_bt", "personal_device"}
+        };
+        const std::vector<std::string> authPool = {
+            "home_bt", "unknown_device", "office_wifi", "car_bt", "tv_system",
+            "printer_bt", "public_wifi", "strange_device"
+        };
+        std::mt19937 gen(61);
+        std::normal_distribution<float> dis(0.0f, 1.0f);
+        
+        // Frames 0-3 are silence, 4-7 carry a keyword
+        std::vector<std::vector<int32_t>> models;
+        for(int i = 0; i < KEYWORD_MODELS; i++) {
+            models.push_back(std::vector<int32_t>(FEATURE_LENGTH, static_cast<int32_t>(std::lround(0.1f * (i + 1) * 256))));
+            writeWords(modelAddress + 4 * FEATURE_LENGTH * i, std::vector<uint32_t>(models[i].begin(), models[i].end()));
+        }
+        std::vector<uint32_t> detected;
+        for(int frame = 0; frame < SESSION_FRAMES; frame++) {
+            float mean = frame >= SESSION_FRAMES / 2 ? 3.5f : 0.0f;
+            std::vector<int32_t> features(FEATURE_LENGTH);
+            for(auto& feature : features) feature = static_cast<int32_t>(std::lround((mean + dis(gen)) * 16));
+            writeWords(SESSION_FRAME_ADDRESS + 4 * FEATURE_LENGTH * frame, std::vector<uint32_t>(features.begin(), features.end()));
+            detected.push_back(keywordDetected(features, models) ? 1 : 0);
+        }
+        
+        // 16 scans and 16 authentication contexts to draw from
+        std::vector<uint32_t> trustedIds;
+        for(const auto& device : trusted) trustedIds.push_back(deviceId(device));
+        writeWords(TRUSTED_ADDRESS, trustedIds);
+        std::vector<std::vector<uint32_t>> scans(16), contexts(16);
+        for(int i = 0; i < 16; i++) {
+            int count = 1 + gen() % 4;
+            for(int device = 0; device < count; device++) scans[i].push_back(deviceId(scanPool[gen() % scanPool.size()]));
+            writeWords(SCAN_ADDRESS + 16 * i, scans[i]);
+            for(int device = 0; device < 4; device++) contexts[i].push_back(deviceId(authPool[gen() % authPool.size()]));
+            writeWords(AUTH_NEARBY_ADDRESS + 16 * i, contexts[i]);
+        }
+        std::vector<std::vector<uint32_t>> profileIds(profiles.size());
+        for(size_t i = 0; i < profiles.size(); i++) {
+            for(const auto& device : profiles[i]) profileIds[i].push_back(deviceId(device));
+        }
+        for(int user = 0; user < USER_COUNT; user++) {
+            writeWords(USER_TABLE + USER_RECORD_BYTES * user, profileIds[user % profiles.size()]);
+        }
+        std::vector<uint32_t> enrolled(TEMPLATE_WORDS), probe;
+        for(auto& word : enrolled) word = gen();
+        probe = enrolled;
+        for(int flip = 0; flip < 100; flip++) {
+            uint32_t bit = gen() % (32 * TEMPLATE_WORDS);
+            probe[bit / 32] ^= 1u << (bit % 32);
+        }
+        writeWords(ENROLLED_ADDRESS, enrolled);
+        writeWords(PROBE_ADDRESS, probe);
+        uint32_t distance = 0;
+        for(int i = 0; i < TEMPLATE_WORDS; i++) distance += isa::bitCount(enrolled[i] ^ probe[i]);
+        
+        std::vector<uint32_t> schedule;
+        expected.clear();
+        auto call = [&](const Kernel& kernel, std::vector<uint32_t> args, uint32_t result) {
+            args.resize(5, 0);
+            schedule.push_back(kernel.entry);
+            schedule.insert(schedule.end(), args.begin(), args.end());
+            schedule.push_back(0);
+            schedule.push_back(0);
+            expected.push_back(result);
+        };
+        for(int frame = 0; frame < FRAMES_PER_PASS; frame++) {
+            int phase = frame / (FRAMES_PER_PASS / 4);     // quiet, speech, scanning, authentication
+            int features = phase == 1 && frame % 2 == 0 ? SESSION_FRAMES / 2 + frame / 2 % 4 : frame % 4;
+            call(kernels[3], {SESSION_FRAME_ADDRESS + 4 * FEATURE_LENGTH * features, modelAddress,
+                              static_cast<uint32_t>(KEYWORD_MODELS), static_cast<uint32_t>(FEATURE_LENGTH)}, detected[features]);
+            int ticks = phase == 2 ? 6 : 2;
+            for(int tick = 0; tick < ticks; tick++) {
+                int scan = gen() % 16;
+                uint32_t location = gen() % 6;
+                call(kernels[2], {SCAN_ADDRESS + 16 * scan, static_cast<uint32_t>(scans[scan].size()), TRUSTED_ADDRESS,
+                                  static_cast<uint32_t>(trustedIds.size()), location},
+                     expectedTrustLevel(scans[scan], trustedIds, location));
+            }
+            if(phase == 3 || frame % 8 == 0) {
+                int context = gen() % 16;
+                uint32_t user = gen() % USER_COUNT;
+                const std::vector<uint32_t>& userProfile = profileIds[user % profiles.size()];
+                bool trustedContext = false;
+                for(uint32_t id : userProfile) {
+                    trustedContext = trustedContext || std::find(contexts[context].begin(), contexts[context].end(), id) != contexts[context].end();
+                }
+                call(kernels[4], {ENROLLED_ADDRESS, PROBE_ADDRESS, static_cast<uint32_t>(TEMPLATE_WORDS)}, distance);
+                call(kernels[1], {USER_TABLE + USER_RECORD_BYTES * user, static_cast<uint32_t>(userProfile.size()),
+                                  AUTH_NEARBY_ADDRESS + 16 * context, 4}, trustedContext ? 1 : 0);
+            }
+        }
+        writeWords(SESSION_SCHEDULE_ADDRESS, schedule);
+        return static_cast<uint32_t>(expected.size());
+    }
+    
+    void evaluateHardwareLoop() {
+        std::cout << "\n=== Hardware Loop Proposal (LOOP + loop buffer) ===" << std::endl;
+        std::cout << "Pipeline model over 50 frames; the loop buffer holds " << isa::MAX_LOOP_BODY
+                  << " instructions" << std::endl;
+        isa::PowerModel power;
+        const int pairs[][2] = {{0, 10}, {3, 11}};   // plain kernel, LOOP version
+        
+        for(const auto& pair : pairs) {
+            std::cout << "\n--- " << kernels[pair[0]].name << " vs " << kernels[pair[1]].name << " ("
+                      << kernels[pair[0]].prototype << ") ---" << std::endl;
+            std::cout << "  Kernel                 Instr/call  Cycles/call  Speedup  I-mem reads  Buffer reads  Fetch nJ  Core nJ"
+                      << std::endl;
+            double baseCycles = 0.0, baseFetch = 0.0, baseCore = 0.0;
+            for(int v = 0; v < 2; v++) {
+                int k = pair[v];
+                engine = PIPELINE;
+                KernelStats stats = pair[0] == 0 ? runVoiceKernel(50, k) : runKeywordKernel(50, k);
+                engine = FUNCTIONAL;
+                const isa::Activity& activity = stats.pipeline.activity;
+                double calls = static_cast<double>(stats.calls);
+                double cycles = stats.pipeline.cycles / calls;
+                double fetch = (power.picojoules(activity, isa::EVENT_FETCH) +
+                                power.picojoules(activity, isa::EVENT_LOOP_BUFFER)) / calls / 1e3;
+                double core = power.totalPicojoules(activity) / calls / 1e3;
+                if(v == 0) {
+                    baseCycles = cycles;
+                    baseFetch = fetch;
+                    baseCore = core;
+                }
+                
+                char line[160];
+                std::snprintf(line, sizeof(line), "  %-22s %10.1f  %11.1f  %6.2fx  %11.1f  %12.1f  %8.2f  %7.2f",
+                              kernels[k].name, stats.instructions / calls, cycles, baseCycles / cycles,
+                              activity.counts[isa::EVENT_FETCH] / calls, activity.counts[isa::EVENT_LOOP_BUFFER] / calls,
+                              fetch, core);
+                std::cout << line << std::endl;
+                if(stats.mismatches != 0) {
+                    std::cout << "❌ " << stats.mismatches << " results differ from the C++ reference" << std::endl;
+                }
+                if(v == 1) {
+                    std::snprintf(line, sizeof(line), "📐 LOOP saves %.1f%% of cycles, %.1f%% of fetch energy and %.1f%% of core energy",
+                                  100.0 * (1.0 - cycles / baseCycles), 100.0 * (1.0 - fetch / baseFetch),
+                                  100.0 * (1.0 - core / baseCore));
+                    std::cout << line << std::endl;
+                }
+            }
+        }
+    }
+    
+    void disassembleKernels() {
+        for(const auto& kernel : kernels) {
+            std::cout << "\n--- " << kernel.name << " ---" << std::endl;
+            for(uint32_t pc = kernel.entry; pc < kernel.entry + kernel.bytes; pc += 2) {
+                char prefix[24];
+                std::snprintf(prefix, sizeof(prefix), "0x%04x: %04x  ", pc, machine.readHalf(pc));
+                std::cout << prefix << isa::disassemble(machine.readHalf(pc), pc) << std::endl;
+            }
+        }
+    }
+    
+    void showIsaInfo() {
+        std::cout << "\n=== Custom ISA Characteristics ===" << std::endl;
+        std::cout << "• Fixed 16-bit R/I instructions, 4-bit opcode" << std::endl;
+        std::cout << "• 16 x 32-bit registers (x0 = 0, x14 = SP, x15 = LR)" << std::endl;
+        std::cout << "• Custom ops: MAC, VCMPEQ.B, BCNT (MULI #0), SLEEPM (system op)" << std::endl;
+        std::cout << "• 4-bit sign-extended immediates; branches reach -8..+7 instructions" << std::endl;
+        std::cout << "• Functional ISS with decoded-instruction cache and threaded dispatch" << std::endl;
+        std::cout << "• Cycle-level 5-stage pipeline with forwarding and hazard accounting" << std::endl;
+        std::cout << "• Kernels assembled and linked from kernels/*.s at start-up" << std::endl;
+        std::cout << "• x86-64 basic-block JIT with block chaining and store-to-code invalidation" << std::endl;
+        std::cout << "• Configurable L1I/L1D, optional L2 and DRAM latency on the pipeline model" << std::endl;
+        std::cout << "• Pluggable branch predictors: not-taken, BTFN, bimodal, gshare, TAGE-lite" << std::endl;
+        std::cout << "• Packed-SIMD extension, 4-32 bytes: VLD, VCMPEQ, VXOR, VPOPC, VMAC, VREDSUM" << std::endl;
+        std::cout << "• Experimental DOT4.B / DOT2.H: MAC under MACMODE 1 / 2 (system op)" << std::endl;
+        std::cout << "• Activity-based core energy model with clock-gated stages and sleep modes" << std::endl;
+        std::cout << "• Experimental LOOP (system op) with an 8-instruction loop buffer" << std::endl;
+        std::cout << "• Trace-driven pipeline fed by operation traces from the C++ prototypes" << std::endl;
+        std::cout << "• N-core configuration with private L1s and MSI snooping on a shared bus" << std::endl;
+        std::cout << "• Heterogeneous big.LITTLE pair (dual issue + MAC array / minimal core) with task placement" << std::endl;
+        std::cout << "• DMA engine and interrupt controller; SLEEPM waits for a wake-up interrupt" << std::endl;
+        std::cout << "• SimPoint-style sampling: basic-block vectors, k-means, checkpoints" << std::endl;
+    }
+
+private:
+    // Gate-equivalent estimate of the SIMD extension at a width, on top of
+    // the base core and its one 32-bit MAC: 6 GE per register-file bit,
+    // 7 kGE per extra 32x32 multiplier, a 32-bit accumulator and adder per
+    // lane, 20 GE per byte comparator, 2.5 GE per XOR bit, 6 GE per bit of
+    // popcount tree and 4 GE per bit the load port widens beyond 32
+    static double simdAreaKge(uint32_t bytes) {
+        double bits = 8.0 * bytes;
+        double lanes = bytes / 4.0;
+        double gates = isa::VECTOR_REGS * bits * 6.0 + (lanes - 1) * 7000.0 + lanes * (32 * 6.0 + 250.0)
+                     + bytes * 20.0 + bits * (2.5 + 6.0) + (bits - 32) * 4.0;
+        return gates / 1000.0;
+    }
+    
+    // Runs kernel k's pipeline workload with hierarchy attached (nullptr:
+    // ideal memory)
+    KernelStats runWithHierarchy(int k, isa::MemoryHierarchy* hierarchy) {
+        memory = hierarchy;
+        pipeline.setMemory(hierarchy);
+        KernelStats stats = runPipelineWorkload(k);
+        pipeline.setMemory(nullptr);
+        memory = nullptr;
+        return stats;
+    }
+    
+    KernelStats runWithPredictor(int k, isa::BranchPredictor* predictor) {
+        pipeline.setPredictor(predictor);
+        KernelStats stats = runPipelineWorkload(k);
+        pipeline.setPredictor(nullptr);
+        return stats;
+    }
+    
+    // Kernel k's workload at the pipeline model's sizes
+    KernelStats runPipelineWorkload(int k) {
+        engine = PIPELINE;
+        KernelStats stats = k == 0 ? runVoiceKernel(100) : k == 1 ? runBiometricKernel(20000)
+                          : k == 2 ? runConnectivityKernel(20000) : runKeywordKernel(100);
+        engine = FUNCTIONAL;
+        return stats;
+    }
+    
+    // Runs one kernel call to completion and returns x1
+    uint32_t callKernel(const Kernel& kernel, const std::vector<uint32_t>& args, KernelStats& stats) {
+        machine.reset();
+        for(size_t i = 0; i < args.size(); i++) machine.regs[1 + i] = args[i];
+        machine.regs[isa::REG_LR] = powerOffAddress;
+        machine.pc = kernel.entry;
+        
+        isa::Machine::Status status;
+        if(engine == PIPELINE) {
+            pipeline.stats.clear();
+            status = pipeline.run(100000000);
+            stats.pipeline.add(pipeline.stats);
+        } else if(engine == JIT) {
+            status = jit.run(100000000);
+        } else {
+            status = machine.run(100000000);
+        }
+        if(status != isa::Machine::HALTED) {
+            std::cout << "❌ " << kernel.name << " stopped at pc 0x" << std::hex << machine.pc << std::dec
+                      << ": " << (status == isa::Machine::FAULT ? machine.fault : "instruction limit") << std::endl;
+        }
+        stats.calls++;
+        stats.instructions += machine.instret;
+        for(int kind = 0; kind < isa::K_COUNT; kind++) stats.kindCounts[kind] += machine.kindCounts[kind];
+        return machine.regs[1];
+    }
+    
+    void writeWords(uint32_t address, const std::vector<uint32_t>& words) {
+        for(size_t i = 0; i < words.size(); i++) machine.writeWord(address + 4 * i, words[i]);
+        if(memory != nullptr) memory->invalidate(address, static_cast<uint32_t>(4 * words.size()));
+    }
+    
+    static uint32_t deviceId(const std::string& name) {
+        uint32_t hash = 2166136261u; // FNV-1a
+        for(unsigned char c : name) hash = (hash ^ c) * 16777619u;
+        return hash;
+    }
+    
+    // matchKeywords() in fixed point: features in Q4, models in Q8; kernel
+    // k is computeSimilarity or a variant of it
+    KernelStats runVoiceKernel(int frames, int k = 0) {
+        const uint32_t featureAddress = DATA_BASE;
+        const uint32_t modelAddress = DATA_BASE + 4 * FEATURE_LENGTH;
+        std::vector<std::vector<int32_t>> models;
+        for(int i = 0; i < 3; i++) {
+            models.push_back(std::vector<int32_t>(FEATURE_LENGTH, static_cast<int32_t>(std::lround(0.1f * (i + 1) * 256))));
+            writeWords(modelAddress + 4 * FEATURE_LENGTH * i,
+                       std::vector<uint32_t>(models[i].begin(), models[i].end()));
+        }
+        
+        std::mt19937 gen(61);
+        std::normal_distribution<float> dis(0.0f, 1.0f);
+        KernelStats stats;
+        for(int frame = 0; frame < frames; frame++) {
+            std::vector<int32_t> features(FEATURE_LENGTH);
+            for(auto& feature : features) feature = static_cast<int32_t>(std::lround(dis(gen) * 16));
+            writeWords(featureAddress, std::vector<uint32_t>(features.begin(), features.end()));
+            
+            for(int model = 0; model < 3; model++) {
+                auto start = std::chrono::high_resolution_clock::now();
+                uint32_t result = callKernel(kernels[k], {featureAddress, modelAddress + 4 * FEATURE_LENGTH * model,
+                                                          static_cast<uint32_t>(FEATURE_LENGTH)}, stats);
+                auto end = std::chrono::high_resolution_clock::now();
+                stats.seconds += std::chrono::duration<double>(end - start).count();
+                
+                int32_t expected = 0;
+                for(int i = 0; i < FEATURE_LENGTH; i++) expected += features[i] * models[model][i];
+                if(static_cast<int32_t>(result) != expected) stats.mismatches++;
+            }
+        }
+        return stats;
+    }
+    
+    // matchKeywords() (or kernel k, a variant of it) over whole frames;
+    // every fourth frame carries a strong keyword (feature mean 3.5) that
+    // the third model should accept. With lanes 2 or 4 the elements are
+    // saturated to int16/int8 and packed that many to a word.
+    KernelStats runKeywordKernel(int frames, int k = 3, int lanes = 1) {
+        const uint32_t featureAddress = DATA_BASE;
+        const uint32_t modelAddress = DATA_BASE + 4 * FEATURE_LENGTH;
+        std::vector<std::vector<int32_t>> models;
+        for(int i = 0; i < KEYWORD_MODELS; i++) {
+            models.push_back(std::vector<int32_t>(FEATURE_LENGTH, static_cast<int32_t>(std::lround(0.1f * (i + 1) * 256))));
+            saturate(models[i], lanes);
+            writeWords(modelAddress + 4 * FEATURE_LENGTH / lanes * i, pack(models[i], lanes));
+        }
+        
+        std::mt19937 gen(61);
+        std::normal_distribution<float> dis(0.0f, 1.0f);
+        KernelStats stats;
+        for(int frame = 0; frame < frames; frame++) {
+            float mean = frame % 4 == 0 ? 3.5f : 0.0f;
+            std::vector<int32_t> features(FEATURE_LENGTH);
+            for(auto& feature : features) feature = static_cast<int32_t>(std::lround((mean + dis(gen)) * 16));
+            saturate(features, lanes);
+            writeWords(featureAddress, pack(features, lanes));
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            uint32_t result = callKernel(kernels[k], {featureAddress, modelAddress, static_cast<uint32_t>(KEYWORD_MODELS),
+                                                      static_cast<uint32_t>(FEATURE_LENGTH / lanes)}, stats);
+            auto end = std::chrono::high_resolution_clock::now();
+            stats.seconds += std::chrono::duration<double>(end - start).count();
+            
+            if(result != (keywordDetected(features, models) ? 1u : 0u)) stats.mismatches++;
+        }
+        return stats;
+    }
+    
+    // isTrustedEnvironment() against random scans for random users; each
+    // user's profile is a record in a 16KB table, built from the three
+    // prototype profiles, so successive calls touch unrelated lines
+    KernelStats runBiometricKernel(int calls) {
+        const std::vector<std::vector<std::string>> profiles = {
+            {"home_bt", "car_bt"}, {"office_wifi"}, {"home_bt", "personal_device"}
+        };
+        const std::vector<std::string> pool = {
+            "home_bt", "unknown_device", "office_wifi", "car_bt", "tv_system",
+            "printer_bt", "public_wifi", "strange_device"
+        };
+        const uint32_t nearbyAddress = DATA_BASE + 0x100;
+        std::vector<std::vector<uint32_t>> profileIds(profiles.size());
+        for(size_t i = 0; i < profiles.size(); i++) {
+            for(const auto& device : profiles[i]) profileIds[i].push_back(deviceId(device));
+        }
+        for(int user = 0; user < USER_COUNT; user++) {
+            writeWords(USER_TABLE + USER_RECORD_BYTES * user, profileIds[user % profiles.size()]);
+        }
+        
+        std::mt19937 gen(61);
+        KernelStats stats;
+        for(int call = 0; call < calls; call++) {
+            uint32_t user = gen() % USER_COUNT;
+            const std::vector<uint32_t>& profile = profileIds[user % profiles.size()];
+            std::vector<uint32_t> nearbyIds;
+            for(int i = 0; i < 4; i++) nearbyIds.push_back(deviceId(pool[gen() % pool.size()]));
+            writeWords(nearbyAddress, nearbyIds);
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            uint32_t result = callKernel(kernels[1], {USER_TABLE + USER_RECORD_BYTES * user, static_cast<uint32_t>(profile.size()),
+                                                      nearbyAddress, static_cast<uint32_t>(nearbyIds.size())}, stats);
+            auto end = std::chrono::high_resolution_clock::now();
+            stats.seconds += std::chrono::duration<double>(end - start).count();
+            
+            bool expected = false;
+            for(uint32_t id : profile) {
+                expected = expected || std::find(nearbyIds.begin(), nearbyIds.end(), id) != nearbyIds.end();
+            }
+            if(result != (expected ? 1u : 0u)) stats.mismatches++;
+        }
+        return stats;
+    }
+    
+    // matchKeywords() on the host: |similarity| / length > 0.85 with Q4 x Q8
+    // products
+    static bool keywordDetected(const std::vector<int32_t>& features, const std::vector<std::vector<int32_t>>& models) {
+        bool detected = false;
+        for(const auto& model : models) {
+            int64_t dot = 0;
+            for(int i = 0; i < FEATURE_LENGTH; i++) dot += features[i] * model[i];
+            detected = detected || std::llabs(dot) * 100 > 85LL * 4096 * FEATURE_LENGTH;
+        }
+        return detected;
+    }
+    
+    // Same chain as trustLevelFor() in the connectivity prototype
+    static uint32_t expectedTrustLevel(const std::vector<uint32_t>& nearbyIds, const std::vector<uint32_t>& trustedIds,
+                                       uint32_t location) {
+        int trustedCount = 0;
+        for(uint32_t id : nearbyIds) {
+            if(std::find(trustedIds.begin(), trustedIds.end(), id) != trustedIds.end()) trustedCount++;
+        }
+        return (location == 0 && trustedCount >= 2) ? 0 : trustedCount >= 1 ? 1 : location == 5 ? 3 : 2;
+    }
+    
+    // Clamps every element to the signed range of a 32 / lanes bit lane
+    static void saturate(std::vector<int32_t>& values, int lanes) {
+        if(lanes == 1) return;
+        int32_t limit = lanes == 4 ? 127 : 32767;
+        for(auto& value : values) value = std::max(-limit - 1, std::min(limit, value));
+    }
+    
+    // Packs lanes elements per word, lowest lane first
+    static std::vector<uint32_t> pack(const std::vector<int32_t>& values, int lanes) {
+        std::vector<uint32_t> words(values.size() / lanes, 0);
+        uint32_t bits = 32 / lanes;
+        uint32_t mask = lanes == 1 ? 0xFFFFFFFFu : (1u << bits) - 1;
+        for(size_t i = 0; i < values.size(); i++) {
+            words[i / lanes] |= (static_cast<uint32_t>(values[i]) & mask) << (bits * (i % lanes));
+        }
+        return words;
+    }
+    
+    // hammingDistance() (or kernel k) between an enrolled template and a
+    // probe with 0-255 bits flipped
+    KernelStats runHammingKernel(int calls, int k) {
+        const uint32_t enrolledAddress = DATA_BASE;
+        const uint32_t probeAddress = DATA_BASE + 4 * TEMPLATE_WORDS;
+        std::mt19937 gen(61);
+        std::vector<uint32_t> enrolled(TEMPLATE_WORDS);
+        for(auto& word : enrolled) word = gen();
+        writeWords(enrolledAddress, enrolled);
+        
+        KernelStats stats;
+        for(int call = 0; call < calls; call++) {
+            std::vector<uint32_t> probe = enrolled;
+            int flips = gen() % 256;
+            for(int i = 0; i < flips; i++) {
+                uint32_t bit = gen() % (32 * TEMPLATE_WORDS);
+                probe[bit / 32] ^= 1u << (bit % 32);
+            }
+            writeWords(probeAddress, probe);
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            uint32_t result = callKernel(kernels[k], {enrolledAddress, probeAddress,
+                                                      static_cast<uint32_t>(TEMPLATE_WORDS)}, stats);
+            auto end = std::chrono::high_resolution_clock::now();
+            stats.seconds += std::chrono::duration<double>(end - start).count();
+            
+            uint32_t expected = 0;
+            for(int i = 0; i < TEMPLATE_WORDS; i++) expected += isa::bitCount(enrolled[i] ^ probe[i]);
+            if(result != expected) stats.mismatches++;
+        }
+        return stats;
+    }
+    
+    // evaluateTrustLevel() across the six known locations
+    KernelStats runConnectivityKernel(int calls) {
+        const std::vector<std::string> trusted = {"home_wifi", "office_bt", "car_system", "personal_tablet"};
+        const std::vector<std::string> pool = {
+            "home_wifi", "smart_tv", "car_system", "office_bt", "printer_01",
+            "unknown_device_1", "strange_bt_device"
+        };
+        const uint32_t nearbyAddress = DATA_BASE;
+        const uint32_t trustedAddress = DATA_BASE + 0x100;
+        std::vector<uint32_t> trustedIds;
+        for(const auto& device : trusted) trustedIds.push_back(deviceId(device));
+        writeWords(trustedAddress, trustedIds);
+        
+        std::mt19937 gen(61);
+        KernelStats stats;
+        for(int call = 0; call < calls; call++) {
+            uint32_t location = call % 6;
+            std::vector<uint32_t> nearbyIds;
+            int count = 1 + gen() % 4;
+            for(int i = 0; i < count; i++) nearbyIds.push_back(deviceId(pool[gen() % pool.size()]));
+            writeWords(nearbyAddress, nearbyIds);
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            uint32_t result = callKernel(kernels[2], {nearbyAddress, static_cast<uint32_t>(nearbyIds.size()),
+                                                      trustedAddress, static_cast<uint32_t>(trustedIds.size()),
+                                                      location}, stats);
+            auto end = std::chrono::high_resolution_clock::now();
+            stats.seconds += std::chrono::duration<double>(end - start).count();
+            
+            if(result != expectedTrustLevel(nearbyIds, trustedIds, location)) stats.mismatches++;
+        }
+        return stats;
+    }
+    
+    void printKernelStats(const Kernel& kernel, const KernelStats& stats) {
+        std::cout << "\n--- " << kernel.name << " (" << kernel.prototype << ") ---" << std::endl;
+        std::cout << "Calls: " << stats.calls << ", dynamic instructions: " << stats.instructions
+                  << " (" << static_cast<double>(stats.instructions) / stats.calls << " per call)" << std::endl;
+        
+        std::vector<int> kinds;
+        for(int kind = 0; kind < isa::K_COUNT; kind++) {
+            if(stats.kindCounts[kind] > 0) kinds.push_back(kind);
+        }
+        std::sort(kinds.begin(), kinds.end(), [&](int a, int b) {
+            return stats.kindCounts[a] > stats.kindCounts[b];
+        });
+        std::cout << "Mix:";
+        for(int kind : kinds) {
+            char share[32];
+            std::snprintf(share, sizeof(share), " %s %.1f%%", isa::kindName(kind),
+                          100.0 * stats.kindCounts[kind] / stats.instructions);
+            std::cout << share;
+        }
+        std::cout << std::endl;
+        std::cout << "⏱️  Simulation speed: " << stats.instructions / stats.seconds / 1e6 << " MIPS" << std::endl;
+        if(stats.mismatches == 0) {
+            std::cout << "✅ Results match the C++ reference" << std::endl;
+        } else {
+            std::cout << "❌ " << stats.mismatches << " results differ from the C++ reference" << std::endl;
+        }
+    }
+    
+    void printPipelineStats(const Kernel& kernel, const KernelStats& stats) {
+        const isa::PipelineStats& p = stats.pipeline;
+        std::cout << "\n--- " << kernel.name << " (" << kernel.prototype << ") ---" << std::endl;
+        std::cout << "Cycles: " << p.cycles << ", instructions: " << p.instructions
+                  << ", IPC: " << p.ipc() << " (CPI " << 1.0 / p.ipc() << ")" << std::endl;
+        
+        // A wrong-path fetch can miss and then be flushed, so causes may overlap
+        uint64_t lost = p.loadUseStalls + p.macStalls + p.memStalls + p.fetchStalls + p.flushedInstructions;
+        uint64_t fill = p.cycles - p.instructions > lost ? p.cycles - p.instructions - lost : 0;
+        const char* causes[] = {"Load-use", "MAC busy", "Memory", "I-fetch", "Branch flush", "Fill/drain"};
+        uint64_t cycles[] = {p.loadUseStalls, p.macStalls, p.memStalls, p.fetchStalls, p.flushedInstructions, fill};
+        std::cout << "Lost cycles:";
+        for(int i = 0; i < 6; i++) {
+            if(i == 3 && cycles[i] == 0) continue;
+            char share[48];
+            std::snprintf(share, sizeof(share), " %s %.1f%%", causes[i], 100.0 * cycles[i] / p.cycles);
+            std::cout << share << (i < 5 ? "," : "");
+        }
+        std::cout << std::endl;
+        std::cout << "Control transfers: " << p.controlTransfers << ", taken: "
+                  << (p.controlTransfers > 0 ? 100.0 * p.takenTransfers / p.controlTransfers : 0.0) << "%" << std::endl;
+        
+        const char* verdict = p.ipc() < 0.8 ? "below" : p.ipc() > 0.9 ? "above" : "within";
+        std::cout << "📐 Spec claim (IPC 0.8-0.9): " << verdict << std::endl;
+        if(stats.mismatches != 0) {
+            std::cout << "❌ " << stats.mismatches << " results differ from the C++ reference" << std::endl;
+        }
+    }
+};
+
+void displayMenu() {
+    std::cout << "\n==========================================" << std::endl;
+    std::cout << "    CUSTOM PROCESSOR SIMULATOR" << std::endl;
+    std::cout << "==========================================" << std::endl;
+    std::cout << "1. Run Kernel Suite" << std::endl;
+    std::cout << "2. Run Pipeline Model" << std::endl;
+    std::cout << "3. Show Pipeline Cycle Trace" << std::endl;
+    std::cout << "4. Benchmark JIT Backend" << std::endl;
+    std::cout << "5. Run Cache Study" << std::endl;
+    std::cout << "6. Explore Branch Predictors" << std::endl;
+    std::cout << "7. Run SIMD Width Study" << std::endl;
+    std::cout << "8. Evaluate Fused Dot Product" << std::endl;
+    std::cout << "9. Estimate Core Energy" << std::endl;
+    std::cout << "10. Evaluate Hardware Loop" << std::endl;
+    std::cout << "11. Replay Prototype Trace" << std::endl;
+    std::cout << "12. Run Multicore Study" << std::endl;
+    std::cout << "13. Run big.LITTLE Scheduling Study" << std::endl;
+    std::cout << "14. Run Interrupt-Driven Voice Loop" << std::endl;
+    std::cout << "15. Run Sampled Simulation" << std::endl;
+    std::cout << "16. Disassemble Kernels" << std::endl;
+    std::cout << "17. Show ISA Information" << std::endl;
+    std::cout << "18. Exit" << std::endl;
+    std::cout << "==========================================" << std::endl;
+    std::cout << "Choose an option (1-18): ";
+}
+
+int main(int argc, char* argv[]) {
+    ProcessorSim processorSim;
+    int choice;
+    
+    std::cout << "Initializing Custom Processor Simulator..." << std::endl;
+    std::cout << "Focus: Running the prototype kernels on the 16-bit ISA" << std::endl;
+    bool loaded;
+    if(argc > 1 && std::string(argv[1]) == "--image") {
+        if(argc != 4) {
+            std::cerr << "Usage: " << argv[0] << " [kernel directory] | --image image.bin image.map" << std::endl;
+            return 2;
+        }
+        loaded = processorSim.loadImage(argv[2], argv[3]);
+    } else {
+        loaded = processorSim.loadKernels(argc > 1 ? argv[1] : "kernels");
+    }
+    if(!loaded) {
+        return 1;
+    }
+    
+    do {
+        displayMenu();
+        std::cin >> choice;
+        
+        switch(choice) {
+            case 1:
+                processorSim.testKernelSuite();
+                break;
+            case 2:
+                processorSim.testPipelineModel();
+                break;
+            case 3:
+                processorSim.showCycleTrace();
+                break;
+            case 4:
+                processorSim.benchmarkJit();
+                break;
+            case 5:
+                processorSim.runCacheStudy();
+                break;
+            case 6:
+                processorSim.exploreBranchPredictors();
+                break;
+            case 7:
+                processorSim.runSimdStudy();
+                break;
+            case 8:
+                processorSim.evaluateDotProduct();
+                break;
+            case 9:
+                processorSim.estimateEnergy();
+                break;
+            case 10:
+                processorSim.evaluateHardwareLoop();
+                break;
+            case 11: {
+                std::string path;
+                std::cout << "Trace file: ";
+                std::cin >> path;
+                processorSim.replayTrace(path);
+                break;
+            }
+            case 12:
+                processorSim.runMulticoreStudy();
+                break;
+            case 13:
+                processorSim.runBigLittleStudy();
+                break;
+            case 14:
+                processorSim.runInterruptDrivenVoice();
+                break;
+            case 15:
+                processorSim.runSampledSimulation();
+                break;
+            case 16:
+                processorSim.disassembleKernels();
+                break;
+            case 17:
+                processorSim.showIsaInfo();
+                break;
+            case 18:
+                std::cout << "Exiting Custom Processor Simulator. Goodbye!" << std::endl;
+                break;
+            default:
+                std::cout << "Invalid option! Please choose 1-18." << std::endl;
+        }
+    } while(choice != 18);
+    
+    return 0;
+}
@@ -0,0 +1,137 @@
+#ifndef REPORT_SINK_H
+#define REPORT_SINK_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+// Buffered output shared by the workload simulators. Decision code builds a
+// compact result struct, the simulator renders it to text or JSON and hands
+// the string to a ReportSink, so no stream I/O happens inside timed regions.
+//
+// In asynchronous mode a background thread does the actual writes; flush()
+// blocks until everything submitted so far has reached the stream. Callers
+// must flush() before writing to the same stream directly.
+class ReportSink {
+public:
+    enum Format { TEXT, JSON };
+
+private:
+    std::ostream& out;
+    bool asynchronous;
+    std::vector<std::string> pending;
+    bool writerBusy;
+    bool stopping;
+    std::mutex mtx;
+    std::condition_variable pendingReady;
+    std::condition_variable drained;
+    std::thread writer;
+
+    void writeAll(std::vector<std::string>& batch) {
+        for(const auto& text : batch) {
+            out << text;
+        }
+        out.flush();
+        batch.clear();
+    }
+
+    void writerLoop() {
+        std::vector<std::string> batch;
+        std::unique_lock<std::mutex> lock(mtx);
+        while(true) {
+            pendingReady.wait(lock, [this] { return stopping || !pending.empty(); });
+            if(pending.empty() && stopping) break;
+
+            batch.swap(pending);
+            writerBusy = true;
+            lock.unlock();
+            writeAll(batch);
+            lock.lock();
+            writerBusy = false;
+            if(pending.empty()) drained.notify_all();
+        }
+    }
+
+public:
+    Format format;
+
+    explicit ReportSink(std::ostream& stream, bool async = false)
+        : out(stream), asynchronous(async), writerBusy(false), stopping(false), format(TEXT) {
+        if(asynchronous) {
+            writer = std::thread(&ReportSink::writerLoop, this);
+        }
+    }
+
+    ~ReportSink() {
+        if(asynchronous) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            pendingReady.notify_one();
+            writer.join();
+        } else {
+            flush();
+        }
+    }
+
+    void submit(std::string text) {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.push_back(std::move(text));
+        if(asynchronous) pendingReady.notify_one();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mtx);
+        if(asynchronous) {
+            drained.wait(lock, [this] { return pending.empty() && !writerBusy; });
+        } else {
+            writeAll(pending);
+        }
+    }
+
+    const char* formatName() const {
+        return format == JSON ? "JSON" : "text";
+    }
+
+    void toggleFormat() {
+        format = format == JSON ? TEXT : JSON;
+    }
+};
+
+// Quotes a string for use as a JSON value
+inline std::string jsonString(const std::string& value) {
+    std::string quoted = "\"";
+    for(char c : value) {
+        switch(c) {
+            case '"':  quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    quoted += escaped;
+                } else {
+                    quoted += c;
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+inline std::string jsonStringArray(const std::vector<std::string>& values) {
+    std::string array = "[";
+    for(size_t i = 0; i < values.size(); i++) {
+        if(i > 0) array += ",";
+        array += jsonString(values[i]);
+    }
+    return array + "]";
+}
+
+#endif
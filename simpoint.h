@@ -0,0 +1,236 @@
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include "iss.h"
+
+// Sampled simulation in the style of SimPoint. A run is cut into intervals
+// of a fixed number of instructions; the functional ISS profiles each
+// interval's basic-block vector (instructions per block, Machine::
+// blockCounts), the vectors are normalised, randomly projected to a few
+// dimensions and clustered with k-means. The interval nearest each
+// centroid stands for its cluster, weighted by the share of instructions
+// the cluster covers, and only those intervals need detailed simulation.
+//
+// k is the smallest whose Bayesian information criterion reaches 90% of
+// the way from the worst to the best score over 1..maxClusters, as
+// SimPoint chooses it.
+namespace isa {
+
+struct SimPoint {
+    int interval;
+    double weight;          // share of all instructions its cluster covers
+};
+
+class BlockVectorProfile {
+private:
+    uint64_t intervalInstructions;
+    std::vector<uint64_t> counts;
+
+    typedef std::vector<std::pair<uint32_t, uint64_t>> SparseVector;   // (block, instructions)
+
+    static double distance(const std::vector<double>& a, const std::vector<double>& b) {
+        double sum = 0.0;
+        for(size_t i = 0; i < a.size(); i++) sum += (a[i] - b[i]) * (a[i] - b[i]);
+        return sum;
+    }
+
+    // k-means++ seeding, then Lloyd iterations; returns the squared error.
+    // points must not be empty.
+    static double kmeans(const std::vector<std::vector<double>>& points, int k, std::mt19937& gen,
+                         std::vector<int>& assignment, std::vector<std::vector<double>>& centroids) {
+        size_t n = points.size();
+        centroids.assign(1, points[gen() % n]);
+        std::vector<double> nearest(n);
+        while(static_cast<int>(centroids.size()) < k) {
+            double total = 0.0;
+            for(size_t i = 0; i < n; i++) {
+                nearest[i] = std::numeric_limits<double>::max();
+                for(const auto& centroid : centroids) nearest[i] = std::min(nearest[i], distance(points[i], centroid));
+                total += nearest[i];
+            }
+            double pick = std::uniform_real_distribution<double>(0.0, total)(gen);
+            size_t chosen = 0;
+            for(; chosen + 1 < n && pick > nearest[chosen]; chosen++) pick -= nearest[chosen];
+            centroids.push_back(points[chosen]);
+        }
+
+        assignment.assign(n, 0);
+        double error = 0.0;
+        for(int iteration = 0; iteration < 100; iteration++) {
+            bool changed = iteration == 0;
+            error = 0.0;
+            for(size_t i = 0; i < n; i++) {
+                int best = 0;
+                double bestDistance = std::numeric_limits<double>::max();
+                for(int c = 0; c < k; c++) {
+                    double d = distance(points[i], centroids[c]);
+                    if(d < bestDistance) {
+                        bestDistance = d;
+                        best = c;
+                    }
+                }
+                changed = changed || assignment[i] != best;
+                assignment[i] = best;
+                error += bestDistance;
+            }
+            if(!changed) break;
+            std::vector<std::vector<double>> sums(k, std::vector<double>(points[0].size(), 0.0));
+            std::vector<int> sizes(k, 0);
+            for(size_t i = 0; i < n; i++) {
+                sizes[assignment[i]]++;
+                for(size_t d = 0; d < points[i].size(); d++) sums[assignment[i]][d] += points[i][d];
+            }
+            for(int c = 0; c < k; c++) {
+                if(sizes[c] == 0) continue;
+                for(auto& value : sums[c]) value /= sizes[c];
+                centroids[c] = sums[c];
+            }
+        }
+        return error;
+    }
+
+    // X-means BIC of a spherical Gaussian model of the clustering
+    static double bic(size_t n, size_t dimensions, int k, double error, const std::vector<int>& assignment) {
+        std::vector<int> sizes(k, 0);
+        for(int cluster : assignment) sizes[cluster]++;
+        double variance = n > static_cast<size_t>(k) ? error / (n - k) : 0.0;
+        variance = std::max(variance, 1e-12);
+        double likelihood = 0.0;
+        for(int size : sizes) {
+            if(size == 0) continue;
+            likelihood += size * std::log(static_cast<double>(size)) - size * std::log(static_cast<double>(n)) -
+                          size / 2.0 * std::log(2.0 * 3.14159265358979) - size * dimensions / 2.0 * std::log(variance) -
+                          (size - k) / 2.0;
+        }
+        double parameters = (k - 1) + k * static_cast<double>(dimensions) + 1;
+        return likelihood - parameters / 2.0 * std::log(static_cast<double>(n));
+    }
+
+public:
+    std::vector<SparseVector> intervals;
+    std::vector<uint64_t> lengths;      // instructions per interval; the last may be short
+    int clusters;                       // k chosen by choose()
+    std::vector<int> assignment;        // cluster of every interval
+
+    explicit BlockVectorProfile(uint64_t instructionsPerInterval)
+        : intervalInstructions(instructionsPerInterval), counts(Machine::MEMORY_BYTES / 2, 0), clusters(0) {}
+
+    uint64_t interval() const { return intervalInstructions; }
+
+    // Runs machine from its current state until it stops, profiling every
+    // interval; returns the final status
+    Machine::Status profile(Machine& machine) {
+        intervals.clear();
+        lengths.clear();
+        machine.blockCounts = &counts;
+        machine.blockStart = machine.instret;
+        Machine::Status status;
+        do {
+            uint64_t start = machine.instret;
+            status = machine.run(intervalInstructions);
+            SparseVector vector;
+            for(uint32_t block = 0; block < counts.size(); block++) {
+                if(counts[block] == 0) continue;
+                vector.push_back(std::make_pair(block, counts[block]));
+                counts[block] = 0;
+            }
+            if(machine.instret > start) {
+                intervals.push_back(vector);
+                lengths.push_back(machine.instret - start);
+            }
+        } while(status == Machine::STEP_LIMIT);
+        machine.blockCounts = nullptr;
+        return status;
+    }
+
+    // Clusters the profiled intervals and returns one simulation point per
+    // cluster
+    std::vector<SimPoint> choose(int maxClusters, int dimensions = 15, unsigned seed = 61) {
+        clusters = 0;
+        assignment.clear();
+        if(intervals.empty() || maxClusters < 1) return std::vector<SimPoint>();
+
+        // Normalise each vector and project it onto random directions, one
+        // per block drawn on first use
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> direction(-1.0, 1.0);
+        std::vector<std::vector<double>> projection(counts.size());
+        std::vector<std::vector<double>> points;
+        for(const auto& vector : intervals) {
+            uint64_t total = 0;
+            for(const auto& entry : vector) total += entry.second;
+            std::vector<double> point(dimensions, 0.0);
+            for(const auto& entry : vector) {
+                std::vector<double>& row = projection[entry.first];
+                if(row.empty()) {
+                    for(int d = 0; d < dimensions; d++) row.push_back(direction(gen));
+                }
+                for(int d = 0; d < dimensions; d++) point[d] += row[d] * entry.second / std::max<uint64_t>(total, 1);
+            }
+            points.push_back(point);
+        }
+
+        int limit = std::min<int>(maxClusters, static_cast<int>(points.size()));
+        std::vector<std::vector<int>> assignments(limit + 1);
+        std::vector<std::vector<std::vector<double>>> centroids(limit + 1);
+        std::vector<double> scores(limit + 1, 0.0);
+        for(int k = 1; k <= limit; k++) {
+            // Best of a few seedings
+            double bestError = std::numeric_limits<double>::max();
+            for(int attempt = 0; attempt < 5; attempt++) {
+                std::vector<int> candidate;
+                std::vector<std::vector<double>> candidateCentroids;
+                double error = kmeans(points, k, gen, candidate, candidateCentroids);
+                if(error < bestError) {
+                    bestError = error;
+                    assignments[k] = candidate;
+                    centroids[k] = candidateCentroids;
+                }
+            }
+            scores[k] = bic(points.size(), dimensions, k, bestError, assignments[k]);
+        }
+        double low = *std::min_element(scores.begin() + 1, scores.end());
+        double high = *std::max_element(scores.begin() + 1, scores.end());
+        clusters = 1;
+        while(clusters < limit && scores[clusters] < low + 0.9 * (high - low)) clusters++;
+        assignment = assignments[clusters];
+
+        uint64_t instructions = 0;
+        for(uint64_t length : lengths) instructions += length;
+        std::vector<SimPoint> chosen;
+        for(int c = 0; c < clusters; c++) {
+            int representative = -1;
+            double nearest = std::numeric_limits<double>::max();
+            uint64_t covered = 0;
+            for(size_t i = 0; i < points.size(); i++) {
+                if(assignment[i] != c) continue;
+                covered += lengths[i];
+                double d = distance(points[i], centroids[clusters][c]);
+                // A full-length interval represents better than the short tail
+                if(lengths[i] == intervalInstructions && d < nearest) {
+                    nearest = d;
+                    representative = static_cast<int>(i);
+                }
+            }
+            if(representative < 0) {
+                for(size_t i = 0; i < points.size(); i++) {
+                    if(assignment[i] == c) representative = static_cast<int>(i);
+                }
+            }
+            if(representative >= 0) {
+                chosen.push_back(SimPoint{representative, static_cast<double>(covered) / instructions});
+            }
+        }
+        return chosen;
+    }
+};
+
+} // namespace isa
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef TRACE_FRONTEND_H
+#define TRACE_FRONTEND_H
+
+#include <map>
+#include <cstdint>
+#include "isa.h"
+#include "pipeline.h"
+#include "op_trace.h"
+
+// Turns an operation trace from the C++ prototypes (op_trace.h) into the
+// instruction stream Pipeline::replay() times, so the cache and pipeline
+// models see the real kernels' memory addresses and branch outcomes:
+//
+//   load      LW into x1-x6 in turn (base x12)
+//   store     SW of x9
+//   ALU       ADD x9 from the newest load
+//   MAC       MAC x7 from the two newest loads
+//   compare   SUB x8 from the two newest loads
+//   popcount  BCNT x9 from the newest load
+//   branch    BNE on x8
+//
+// The prototypes have no program counters, so code is laid out as it is
+// first seen: every (kernel, previous branch site, outcome) gets a 64-byte
+// block, the operations after that branch run sequentially from its start
+// and a taken branch targets the block for its own site and outcome. Host
+// addresses keep their low 32 bits.
+namespace isa {
+
+class OperationSteps : public StepSource {
+private:
+    static const uint32_t BLOCK_BYTES = 64;
+    static const int ENTRY_SITE = 16;   // the block a MARK starts
+
+    optrace::Reader& reader;
+    int kernel;                 // the kernel whose calls to replay, or -1 for all
+    int current;                // kernel of the call in progress, -1 before the first
+    std::map<int, uint32_t> blocks;
+    uint32_t blockPc;
+    uint32_t offset;
+    int nextLoad;
+    int newest[2];
+
+    uint32_t block(int site, bool taken) {
+        int key = ((current * (ENTRY_SITE + 1) + site) << 1) | (taken ? 1 : 0);
+        auto found = blocks.find(key);
+        if(found != blocks.end()) return found->second;
+        uint32_t pc = static_cast<uint32_t>(blocks.size()) * BLOCK_BYTES;
+        blocks[key] = pc;
+        return pc;
+    }
+
+    void enter(uint32_t pc) {
+        blockPc = pc;
+        offset = 0;
+    }
+
+public:
+    uint64_t calls[optrace::TRACE_KERNEL_COUNT];
+
+    OperationSteps(optrace::Reader& source, int onlyKernel = -1) : reader(source), kernel(onlyKernel) {
+        rewind();
+    }
+
+    void rewind() {
+        reader.rewind();
+        current = -1;
+        blocks.clear();
+        enter(0);
+        nextLoad = 0;
+        newest[0] = newest[1] = 1;
+        for(auto& count : calls) count = 0;
+    }
+
+    // Code the replay has laid out so far
+    uint32_t codeBytes() const {
+        return static_cast<uint32_t>(blocks.size()) * BLOCK_BYTES;
+    }
+
+    bool next(TraceStep& step) override {
+        optrace::Record record;
+        while(reader.next(record)) {
+            if(record.kind == optrace::OP_MARK) {
+                current = record.site < optrace::TRACE_KERNEL_COUNT ? record.site : -1;
+                if(current >= 0) {
+                    calls[current]++;
+                    enter(block(ENTRY_SITE, false));
+                }
+                continue;
+            }
+            if(current < 0 || (kernel >= 0 && current != kernel)) continue;
+
+            // Long straight runs wrap within their block
+            step.pc = blockPc + offset;
+            offset = (offset + 2) % BLOCK_BYTES;
+            step.address = static_cast<uint32_t>(record.address);
+            step.taken = false;
+            switch(record.kind) {
+                case optrace::OP_LOAD:
+                    newest[1] = newest[0];
+                    newest[0] = 1 + nextLoad;
+                    nextLoad = (nextLoad + 1) % 6;
+                    step.in = Instruction{K_LW, static_cast<uint8_t>(newest[0]), 12, 0, 0};
+                    break;
+                case optrace::OP_STORE:
+                    step.in = Instruction{K_SW, 0, 12, 9, 0};
+                    break;
+                case optrace::OP_ALU:
+                    step.in = Instruction{K_ADD, 9, static_cast<uint8_t>(newest[0]), 9, 0};
+                    break;
+                case optrace::OP_MAC:
+                    step.in = Instruction{K_MAC, 7, static_cast<uint8_t>(newest[1]), static_cast<uint8_t>(newest[0]), 0};
+                    break;
+                case optrace::OP_COMPARE:
+                    step.in = Instruction{K_SUB, 8, static_cast<uint8_t>(newest[1]), static_cast<uint8_t>(newest[0]), 0};
+                    break;
+                case optrace::OP_POPCOUNT:
+                    step.in = Instruction{K_BCNT, 9, static_cast<uint8_t>(newest[0]), 0, 0};
+                    break;
+                default: {
+                    uint32_t target = block(record.site, true);
+                    step.in = Instruction{K_BNE, 0, 8, 0, static_cast<int32_t>(target - step.pc - 2)};
+                    step.taken = record.taken;
+                    enter(block(record.site, record.taken));
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+} // namespace isa
+
+#endif
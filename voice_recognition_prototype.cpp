@@ -5,16 +5,29 @@
 #include <chrono>
 #include <thread>
 #include <cmath>
+#include <sstream>
+#include "report_sink.h"
+#include "energy_model.h"
+#include "op_trace.h"
+#include "cli_args.h"
 
 class VoiceRecognitionSim {
 private:
+    // Compact result of one processed audio frame
+    struct FrameResult {
+        int frame;
+        double latencyMs;
+        bool keywordDetected;
+    };
+    
     std::vector<std::vector<float>> keywordModels;
     std::vector<float> audioBuffer;
     const int BUFFER_SIZE = 1024;
     const float RESPONSE_THRESHOLD = 0.85f;
+    ReportSink report;
     
 public:
-    VoiceRecognitionSim() {
+    VoiceRecognitionSim() : report(std::cout, true) {
         initializeKeywordModels();
     }
     
@@ -38,32 +51,26 @@ public:
         
         int totalFrames = 8;
         int latencyViolations = 0;
+        energy::Snapshot energyBefore = energy::snapshot();
         
         for(int frame = 0; frame < totalFrames; frame++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            
-            // Simulate audio processing pipeline
-            simulateAudioCapture();
-            std::vector<float> features = extractFeatures();
-            bool keywordDetected = matchKeywords(features);
-            
-            auto end = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-            
-            std::cout << "Frame " << frame << ": " << duration.count() << "ms, "
-                      << "Keyword: " << (keywordDetected ? "DETECTED" : "none");
-            
-            if(duration.count() > 100) {
-                std::cout << " ⚠️ LATENCY WARNING";
+            FrameResult result = processFrame(frame);
+            if(result.latencyMs > 100) {
                 latencyViolations++;
             }
-            std::cout << std::endl;
+            report.submit(renderFrame(result));
             
             std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            energy::charge(energy::SLEEP_LIGHT_US, 50000);
         }
+        report.flush();
+        energy::Snapshot frameEnergy = energy::snapshot().since(energyBefore);
         
         std::cout << "\nResults: " << latencyViolations << "/" << totalFrames
                   << " frames exceeded 100ms limit" << std::endl;
+        std::cout << "🔋 Energy per keyword frame: " << frameEnergy.totalMilliJoules() / totalFrames
+                  << " mJ" << std::endl;
+        std::cout << frameEnergy.breakdown(totalFrames);
     }
     
     void testKeywordDetection() {
@@ -75,19 +82,15 @@ public:
         int detections = 0;
         
         for(int i = 0; i < tests; i++) {
-            simulateAudioCapture();
-            std::vector<float> features = extractFeatures();
-            bool detected = matchKeywords(features);
-            
-            if(detected) {
+            FrameResult result = processFrame(i);
+            if(result.keywordDetected) {
                 detections++;
-                std::cout << "Test " << i << ": ✅ Keyword detected" << std::endl;
-            } else {
-                std::cout << "Test " << i << ": ❌ No keyword" << std::endl;
             }
+            report.submit(renderDetection(result));
             
             std::this_thread::sleep_for(std::chrono::milliseconds(20));
         }
+        report.flush();
         
         std::cout << "\nDetection Rate: " << detections << "/" << tests
                   << " (" << (detections * 100 / tests) << "%)" << std::endl;
@@ -101,8 +104,86 @@ public:
         std::cout << "• Sesotho language support" << std::endl;
         std::cout << "• Compute-intensive workload" << std::endl;
     }
+    
+    void switchOutputFormat() {
+        report.toggleFormat();
+        std::cout << "Frame reports now rendered as " << report.formatName() << std::endl;
+    }
+    
+    // Records matchKeywords over a number of frames as an operation trace
+    // for the processor simulator's trace-driven pipeline (op_trace.h)
+    bool captureTrace(const std::string& path, int frames) {
+        optrace::Recorder recorder;
+        for(int frame = 0; frame < frames; frame++) {
+            simulateAudioCapture();
+            std::vector<float> features = extractFeatures();
+            optrace::Capture capture(recorder);
+            matchKeywords(features);
+        }
+        std::string error;
+        if(!recorder.save(path, error)) {
+            std::cerr << "❌ " << error << std::endl;
+            return false;
+        }
+        std::cout << "Traced " << frames << " frames: " << recorder.recordCount() << " operations in "
+                  << recorder.byteCount() << " bytes -> " << path << std::endl;
+        return true;
+    }
 
 private:
+    // Runs the audio pipeline for one frame; only the pipeline is timed
+    FrameResult processFrame(int frame) {
+        energy::Snapshot work = energy::threadSnapshot();
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        simulateAudioCapture();
+        std::vector<float> features = extractFeatures();
+        bool keywordDetected = matchKeywords(features);
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        
+        FrameResult result;
+        result.frame = frame;
+        result.latencyMs = std::chrono::duration<double, std::milli>(end - start).count();
+        result.keywordDetected = keywordDetected;
+        energy::chargeCore(energy::threadSnapshot().since(work));
+        return result;
+    }
+    
+    std::string renderFrame(const FrameResult& result) const {
+        std::ostringstream out;
+        if(report.format == ReportSink::JSON) {
+            out << "{\"frame\":" << result.frame << ",\"latencyMs\":" << result.latencyMs
+                << ",\"keyword\":" << (result.keywordDetected ? "true" : "false")
+                << ",\"latencyWarning\":" << (result.latencyMs > 100 ? "true" : "false") << "}\n";
+            return out.str();
+        }
+        
+        out << "Frame " << result.frame << ": " << result.latencyMs << "ms, "
+            << "Keyword: " << (result.keywordDetected ? "DETECTED" : "none");
+        if(result.latencyMs > 100) {
+            out << " ⚠️ LATENCY WARNING";
+        }
+        out << "\n";
+        return out.str();
+    }
+    
+    std::string renderDetection(const FrameResult& result) const {
+        std::ostringstream out;
+        if(report.format == ReportSink::JSON) {
+            out << "{\"test\":" << result.frame
+                << ",\"keyword\":" << (result.keywordDetected ? "true" : "false") << "}\n";
+            return out.str();
+        }
+        
+        if(result.keywordDetected) {
+            out << "Test " << result.frame << ": ✅ Keyword detected\n";
+        } else {
+            out << "Test " << result.frame << ": ❌ No keyword\n";
+        }
+        return out.str();
+    }
+    
     void simulateAudioCapture() {
         audioBuffer.clear();
         std::random_device rd;
@@ -112,6 +193,9 @@ private:
         for(int i = 0; i < BUFFER_SIZE; i++) {
             audioBuffer.push_back(dis(gen));
         }
+        // 1024 samples at 16kHz is 64ms of microphone time
+        energy::charge(energy::AUDIO_CAPTURE_MS, BUFFER_SIZE / 16);
+        energy::charge(energy::SRAM_ACCESS, BUFFER_SIZE);
     }
     
     std::vector<float> extractFeatures() {
@@ -124,25 +208,39 @@ private:
         for(int i = 0; i < 256; i++) {
             features[i] = dis(gen);
         }
+        energy::charge(energy::FEATURE_FRAME);
+        energy::charge(energy::SRAM_ACCESS, BUFFER_SIZE + features.size());
         return features;
     }
     
     bool matchKeywords(const std::vector<float>& features) {
+        optrace::Recorder* trace = optrace::recorder();
+        if(trace) trace->mark(optrace::KERNEL_MATCH_KEYWORDS);
         // Simulate neural network inference
-        for(const auto& model : keywordModels) {
-            float confidence = computeSimilarity(features, model);
-            if(confidence > RESPONSE_THRESHOLD) {
+        for(size_t m = 0; m < keywordModels.size(); m++) {
+            float confidence = computeSimilarity(features, keywordModels[m]);
+            if(optrace::compareBranch(trace, 0, confidence > RESPONSE_THRESHOLD)) {
                 return true;
             }
+            if(trace) trace->branch(1, m + 1 < keywordModels.size());
         }
         return false;
     }
     
     float computeSimilarity(const std::vector<float>& a, const std::vector<float>& b) {
+        optrace::Recorder* trace = optrace::recorder();
         float similarity = 0.0f;
         for(size_t i = 0; i < std::min(a.size(), b.size()); i++) {
             similarity += a[i] * b[i]; // Simulate dot product
+            if(trace) {
+                trace->load(&a[i]);
+                trace->load(&b[i]);
+                trace->mac();
+                trace->branch(2, i + 1 < std::min(a.size(), b.size()));
+            }
         }
+        energy::charge(energy::MAC_OP, std::min(a.size(), b.size()));
+        energy::charge(energy::SRAM_ACCESS, 2 * std::min(a.size(), b.size()));
         return std::abs(similarity) / std::min(a.size(), b.size());
     }
 };
@@ -153,13 +251,24 @@ void displayMenu() {
     std::cout << "==========================================" << std::endl;
     std::cout << "1. Test Real-time Processing" << std::endl;
     std::cout << "2. Test Keyword Detection" << std::endl;
-    std::cout << "3. Show Workload Information" << std::endl;
-    std::cout << "4. Exit" << std::endl;
+    std::cout << "3. Switch Output Format (text/JSON)" << std::endl;
+    std::cout << "4. Show Workload Information" << std::endl;
+    std::cout << "5. Exit" << std::endl;
     std::cout << "==========================================" << std::endl;
-    std::cout << "Choose an option (1-4): ";
+    std::cout << "Choose an option (1-5): ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if(argc > 1) {
+        int frames = 8;
+        if(std::string(argv[1]) != "--trace" || argc < 3 || argc > 4 || (argc > 3 && !cli::parseCount(argv[3], frames))) {
+            std::cerr << "Usage: " << argv[0] << " [--trace PATH [FRAMES]]  (FRAMES a positive integer)" << std::endl;
+            return 2;
+        }
+        VoiceRecognitionSim voiceSim;
+        return voiceSim.captureTrace(argv[2], frames) ? 0 : 1;
+    }
+    
     VoiceRecognitionSim voiceSim;
     int choice;
     
@@ -178,15 +287,18 @@ int main() {
                 voiceSim.testKeywordDetection();
                 break;
             case 3:
-                voiceSim.showWorkloadInfo();
+                voiceSim.switchOutputFormat();
                 break;
             case 4:
+                voiceSim.showWorkloadInfo();
+                break;
+            case 5:
                 std::cout << "Exiting Voice Recognition Simulator. Goodbye!" << std::endl;
                 break;
             default:
-                std::cout << "Invalid option! Please choose 1-4." << std::endl;
+                std::cout << "Invalid option! Please choose 1-5." << std::endl;
         }
-    } while(choice != 4);
+    } while(choice != 5);
     
     return 0;
 }